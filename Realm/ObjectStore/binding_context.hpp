@@ -19,8 +19,10 @@
 #ifndef BINDING_CONTEXT_HPP
 #define BINDING_CONTEXT_HPP
 
+#include "commit_stats.hpp"
 #include "index_set.hpp"
 
+#include <string>
 #include <tuple>
 #include <vector>
 
@@ -74,6 +76,14 @@ public:
     // a different Realm instance (possibly in a different process)
     virtual void changes_available() { }
 
+    // Override this function to limit which commits made by other Realm
+    // instances wake up the Realm to the ones which modify the returned object
+    // types, in addition to those passed to Realm::set_observed_object_types().
+    // Returning an empty vector when no types have been set on the Realm means
+    // that all commits are observed.
+    // This is called after each time the Realm is notified of changes.
+    virtual std::vector<std::string> get_observed_object_types() { return {}; }
+
     struct ObserverState;
 
     // Override this function if you want to recieve detailed information about
@@ -100,6 +110,10 @@ public:
     virtual void did_change(std::vector<ObserverState> const& observers,
                             std::vector<void*> const& invalidated);
 
+    // Called after a write transaction is committed by this Realm instance if
+    // its config has record_commit_stats set, with what the transaction did.
+    virtual void did_commit(CommitStats const&) { }
+
     // Change information for a single field of a row
     struct ColumnInfo {
         // Did this column change?
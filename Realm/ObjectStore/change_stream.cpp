@@ -0,0 +1,453 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "change_stream.hpp"
+
+#include "impl/transact_log_handler.hpp"
+#include "impl/transaction_change_info.hpp"
+#include "object_schema.hpp"
+#include "object_store.hpp"
+
+#include <realm/commit_log.hpp>
+#include <realm/group_shared.hpp>
+#include <realm/link_view.hpp>
+#include <realm/table.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <unordered_map>
+
+using namespace realm;
+using namespace realm::_impl;
+
+namespace {
+// Reads the objects which were changed between two versions out of the Groups
+// for those versions
+class ChangeCollector {
+public:
+    ChangeCollector(Group& old_group, Group& new_group, std::vector<ObjectChange>& out)
+    : m_old_group(old_group), m_new_group(new_group), m_out(out) { }
+
+    void collect(size_t table_ndx, TableChangeInfo const& changes)
+    {
+        StringData object_type = ObjectStore::object_type_for_table_name(m_new_group.get_table_name(table_ndx));
+        if (!object_type.size()) {
+            // Not a table for an object type
+            return;
+        }
+        auto& object_schema = schema_for(object_type, m_new_group, m_new_schemas);
+        Table& table = *m_new_group.get_table(table_ndx);
+
+        if (changes.cleared() || changes.untracked()) {
+            // None of the old rows can be matched up with the new ones, so
+            // everything which exists now has to be reported
+            append(ObjectChange::Kind::Clear, object_schema.name, ChangeValue(), npos);
+            for (size_t row = 0, size = table.size(); row < size; ++row) {
+                append_insertion(object_schema, table, row);
+            }
+            return;
+        }
+
+        std::vector<size_t> rows(changes.deleted_rows().begin(), changes.deleted_rows().end());
+        if (!rows.empty()) {
+            std::sort(rows.begin(), rows.end());
+            // Deleted objects only exist in the old version, in which the
+            // table may have a different index or columns
+            auto& old_schema = schema_for(object_type, m_old_group, m_old_schemas);
+            Table& old_table = *ObjectStore::table_for_object_type(&m_old_group, object_type);
+            for (size_t row : rows) {
+                append(ObjectChange::Kind::Delete, object_schema.name,
+                       primary_key(old_schema, old_table, row, m_old_group, m_old_schemas), row);
+            }
+        }
+
+        rows.assign(changes.modified_rows().begin(), changes.modified_rows().end());
+        std::sort(rows.begin(), rows.end());
+        for (size_t old_ndx : rows) {
+            size_t row = changes.new_index(old_ndx);
+            auto columns = changes.modified_columns(old_ndx);
+            auto& change = append(ObjectChange::Kind::Modify, object_schema.name,
+                                  primary_key(object_schema, table, row), row);
+            for (auto const& prop : object_schema.properties) {
+                if (!columns || (prop.table_column < columns->size() && (*columns)[prop.table_column])) {
+                    change.values.push_back({prop.name, value(prop, table, row)});
+                }
+            }
+        }
+
+        rows = changes.inserted_rows();
+        std::sort(rows.begin(), rows.end());
+        for (size_t row : rows) {
+            append_insertion(object_schema, table, row);
+        }
+    }
+
+private:
+    using SchemaCache = std::unordered_map<std::string, ObjectSchema>;
+
+    Group& m_old_group;
+    Group& m_new_group;
+    std::vector<ObjectChange>& m_out;
+    // Schemas for each object type seen so far in each version
+    SchemaCache m_old_schemas;
+    SchemaCache m_new_schemas;
+
+    static ObjectSchema const& schema_for(StringData object_type, Group& group, SchemaCache& cache)
+    {
+        std::string name = object_type;
+        auto it = cache.find(name);
+        if (it == cache.end()) {
+            it = cache.emplace(name, ObjectSchema(&group, name)).first;
+        }
+        return it->second;
+    }
+
+    ObjectChange& append(ObjectChange::Kind kind, std::string const& object_type, ChangeValue primary_key, size_t row_ndx)
+    {
+        m_out.push_back({kind, object_type, std::move(primary_key), row_ndx, {}});
+        return m_out.back();
+    }
+
+    void append_insertion(ObjectSchema const& object_schema, Table& table, size_t row)
+    {
+        auto& change = append(ObjectChange::Kind::Insert, object_schema.name,
+                              primary_key(object_schema, table, row), row);
+        change.values.reserve(object_schema.properties.size());
+        for (auto const& prop : object_schema.properties) {
+            change.values.push_back({prop.name, value(prop, table, row)});
+        }
+    }
+
+    ChangeValue primary_key(ObjectSchema const& object_schema, Table& table, size_t row)
+    {
+        return primary_key(object_schema, table, row, m_new_group, m_new_schemas);
+    }
+
+    static ChangeValue primary_key(ObjectSchema const& object_schema, Table& table, size_t row,
+                                   Group& group, SchemaCache& cache)
+    {
+        if (auto prop = object_schema.primary_key_property()) {
+            return value(*prop, table, row, group, cache);
+        }
+        ChangeValue none;
+        none.null = true;
+        return none;
+    }
+
+    ChangeValue value(Property const& prop, Table& table, size_t row)
+    {
+        return value(prop, table, row, m_new_group, m_new_schemas);
+    }
+
+    // Links are represented by the primary keys of the linked objects, and are
+    // null if the linked type has no primary key
+    static ChangeValue value(Property const& prop, Table& table, size_t row, Group& group, SchemaCache& cache)
+    {
+        ChangeValue value;
+        value.type = prop.type;
+        size_t col = prop.table_column;
+        if (prop.is_nullable && prop.type != PropertyTypeObject && table.is_null(col, row)) {
+            value.null = true;
+            return value;
+        }
+
+        switch (prop.type) {
+            case PropertyTypeInt:
+                value.int_value = table.get_int(col, row);
+                break;
+            case PropertyTypeBool:
+                value.int_value = table.get_bool(col, row);
+                break;
+            case PropertyTypeFloat:
+                value.double_value = table.get_float(col, row);
+                break;
+            case PropertyTypeDouble:
+                value.double_value = table.get_double(col, row);
+                break;
+            case PropertyTypeString: {
+                StringData str = table.get_string(col, row);
+                value.null = str.is_null();
+                value.string_value.assign(str.data(), str.size());
+                break;
+            }
+            case PropertyTypeData: {
+                BinaryData data = table.get_binary(col, row);
+                value.null = data.is_null();
+                value.string_value.assign(data.data(), data.size());
+                break;
+            }
+            case PropertyTypeDate:
+                value.int_value = table.get_datetime(col, row).get_datetime();
+                break;
+            case PropertyTypeAny:
+                value.null = true;
+                break;
+            case PropertyTypeObject: {
+                auto& target_schema = schema_for(prop.object_type, group, cache);
+                if (table.is_null_link(col, row) || !target_schema.primary_key_property()) {
+                    value.null = true;
+                    break;
+                }
+                Table& target = *table.get_link_target(col);
+                value.links.push_back(primary_key(target_schema, target, table.get_link(col, row), group, cache));
+                break;
+            }
+            case PropertyTypeArray: {
+                auto& target_schema = schema_for(prop.object_type, group, cache);
+                if (!target_schema.primary_key_property()) {
+                    value.null = true;
+                    break;
+                }
+                Table& target = *table.get_link_target(col);
+                auto link_view = table.get_linklist(col, row);
+                value.links.reserve(link_view->size());
+                for (size_t i = 0, size = link_view->size(); i < size; ++i) {
+                    value.links.push_back(primary_key(target_schema, target, link_view->get(i).get_index(), group, cache));
+                }
+                break;
+            }
+        }
+        return value;
+    }
+};
+
+void write_json_string(std::ostream& out, char const* data, size_t size)
+{
+    static char const hex[] = "0123456789abcdef";
+    out << '"';
+    for (size_t i = 0; i < size; ++i) {
+        unsigned char c = data[i];
+        switch (c) {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\r': out << "\\r"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    out << "\\u00" << hex[c >> 4] << hex[c & 0xf];
+                }
+                else {
+                    out << c;
+                }
+        }
+    }
+    out << '"';
+}
+
+void write_json_base64(std::ostream& out, std::string const& data)
+{
+    static char const alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    out << '"';
+    for (size_t i = 0; i < data.size(); i += 3) {
+        uint32_t chunk = uint32_t(uint8_t(data[i])) << 16;
+        if (i + 1 < data.size()) chunk |= uint32_t(uint8_t(data[i + 1])) << 8;
+        if (i + 2 < data.size()) chunk |= uint8_t(data[i + 2]);
+        out << alphabet[(chunk >> 18) & 63] << alphabet[(chunk >> 12) & 63];
+        out << (i + 1 < data.size() ? alphabet[(chunk >> 6) & 63] : '=');
+        out << (i + 2 < data.size() ? alphabet[chunk & 63] : '=');
+    }
+    out << '"';
+}
+
+void write_json(std::ostream& out, ChangeValue const& value)
+{
+    if (value.null) {
+        out << "null";
+        return;
+    }
+    switch (value.type) {
+        case PropertyTypeInt:
+        case PropertyTypeDate:
+            out << value.int_value;
+            break;
+        case PropertyTypeBool:
+            out << (value.int_value ? "true" : "false");
+            break;
+        case PropertyTypeFloat:
+        case PropertyTypeDouble:
+            // JSON has no representation for NaN or infinity
+            if (std::isfinite(value.double_value)) {
+                out << value.double_value;
+            }
+            else {
+                out << "null";
+            }
+            break;
+        case PropertyTypeString:
+            write_json_string(out, value.string_value.data(), value.string_value.size());
+            break;
+        case PropertyTypeData:
+            write_json_base64(out, value.string_value);
+            break;
+        case PropertyTypeObject:
+            write_json(out, value.links.front());
+            break;
+        case PropertyTypeArray:
+            out << '[';
+            for (size_t i = 0; i < value.links.size(); ++i) {
+                if (i > 0) {
+                    out << ',';
+                }
+                write_json(out, value.links[i]);
+            }
+            out << ']';
+            break;
+        case PropertyTypeAny:
+            out << "null";
+            break;
+    }
+}
+
+char const* string_for_kind(ObjectChange::Kind kind)
+{
+    switch (kind) {
+        case ObjectChange::Kind::Insert: return "insert";
+        case ObjectChange::Kind::Modify: return "modify";
+        case ObjectChange::Kind::Delete: return "delete";
+        case ObjectChange::Kind::Clear:  return "clear";
+    }
+    REALM_UNREACHABLE();
+}
+
+void write_json(std::ostream& out, uint64_t version, ObjectChange const& change)
+{
+    out << "{\"version\":" << version << ",\"kind\":\"" << string_for_kind(change.kind) << "\",\"type\":";
+    write_json_string(out, change.object_type.data(), change.object_type.size());
+    if (change.kind != ObjectChange::Kind::Clear) {
+        out << ",\"primaryKey\":";
+        write_json(out, change.primary_key);
+        out << ",\"row\":" << change.row_ndx;
+    }
+    if (!change.values.empty()) {
+        out << ",\"values\":{";
+        for (size_t i = 0; i < change.values.size(); ++i) {
+            if (i > 0) {
+                out << ',';
+            }
+            write_json_string(out, change.values[i].name.data(), change.values[i].name.size());
+            out << ':';
+            write_json(out, change.values[i].value);
+        }
+        out << '}';
+    }
+    out << "}\n";
+}
+} // anonymous namespace
+
+ChangeStream::ChangeStream(Realm::Config const& config)
+: ChangeStream(config, SharedGroup::VersionID())
+{
+}
+
+ChangeStream::ChangeStream(Realm::Config const& config, SharedGroup::VersionID version)
+: m_config(config)
+{
+    if (m_config.read_only) {
+        throw InvalidTransactionException("Can't read changes from a read-only Realm");
+    }
+    m_shared_group = open(m_history);
+    m_group = &const_cast<Group&>(m_shared_group->begin_read(version));
+}
+
+ChangeStream::~ChangeStream() = default;
+
+std::unique_ptr<SharedGroup> ChangeStream::open(std::unique_ptr<ClientHistory>& history) const
+{
+    history = realm::make_client_history(m_config.path, m_config.encryption_key.data());
+    SharedGroup::DurabilityLevel durability = m_config.in_memory ? SharedGroup::durability_MemOnly :
+                                                                   SharedGroup::durability_Full;
+    return std::make_unique<SharedGroup>(*history, durability, m_config.encryption_key.data(), false);
+}
+
+SharedGroup::VersionID ChangeStream::version() const
+{
+    return m_shared_group->get_version_of_current_transaction();
+}
+
+std::vector<ObjectChange> ChangeStream::read(SharedGroup::VersionID version)
+{
+    return read(version, nullptr);
+}
+
+std::vector<ObjectChange> ChangeStream::read(SharedGroup::VersionID version,
+                                             std::function<void(std::vector<ObjectChange> const&)> const& consume)
+{
+    if (!m_old_shared_group) {
+        m_old_shared_group = open(m_old_history);
+    }
+
+    // The stream's read transaction keeps the old version alive until it's
+    // advanced, and the second read transaction then keeps it alive in case
+    // the stream has to be moved back to it
+    auto old_version = m_shared_group->get_version_of_current_transaction();
+    auto& old_group = const_cast<Group&>(m_old_shared_group->begin_read(old_version));
+    std::vector<ObjectChange> changes;
+    try {
+        TransactionChangeInfo info(true);
+        transaction::advance(*m_shared_group, *m_history, info, version);
+
+        ChangeCollector collector(old_group, *m_group, changes);
+        for (size_t i = 0, count = m_group->size(); i < count; ++i) {
+            if (auto table = info.find(i)) {
+                collector.collect(i, *table);
+            }
+        }
+        if (consume) {
+            consume(changes);
+        }
+    }
+    catch (...) {
+        if (m_shared_group->get_version_of_current_transaction() != old_version) {
+            m_shared_group->end_read();
+            m_group = &const_cast<Group&>(m_shared_group->begin_read(old_version));
+        }
+        m_old_shared_group->end_read();
+        throw;
+    }
+    m_old_shared_group->end_read();
+    return changes;
+}
+
+size_t ChangeStream::append_to_file(std::string const& path, SharedGroup::VersionID version)
+{
+    return read(version, [&](auto const& changes) {
+        if (changes.empty()) {
+            return;
+        }
+
+        // Build all of the lines first so that a failure part way through
+        // doesn't leave a partial set of changes in the file
+        std::ostringstream lines;
+        lines.precision(std::numeric_limits<double>::max_digits10);
+        auto new_version = m_shared_group->get_version_of_current_transaction().version;
+        for (auto const& change : changes) {
+            write_json(lines, new_version, change);
+        }
+
+        std::ofstream out(path, std::ios::out | std::ios::app | std::ios::binary);
+        out << lines.str();
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("Unable to write changes to '" + path + "'");
+        }
+    }).size();
+}
@@ -0,0 +1,156 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_CHANGE_STREAM_HPP
+#define REALM_CHANGE_STREAM_HPP
+
+#include "property.hpp"
+#include "shared_realm.hpp"
+
+#include <realm/group_shared.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace realm {
+class ClientHistory;
+
+// The value of a single property of an object in an ObjectChange
+struct ChangeValue {
+    PropertyType type = PropertyTypeInt;
+    // Set for null values, and for values which can't be represented: those of
+    // `Any` properties and links to objects of types without a primary key
+    bool null = false;
+    // Int and Bool values, and Date values as seconds since 1970
+    int64_t int_value = 0;
+    // Float and Double values
+    double double_value = 0;
+    // String and Data values
+    std::string string_value;
+    // The primary keys of the linked objects for Object and Array values
+    std::vector<ChangeValue> links;
+};
+
+// A change made to a single object between two versions of a Realm
+struct ObjectChange {
+    enum class Kind {
+        // A new object, with the values of all of its properties
+        Insert,
+        // An existing object, with the new values of the properties which
+        // were changed
+        Modify,
+        // An object which was deleted, with no values
+        Delete,
+        // Every object of the type which existed in the old version was
+        // deleted, or the objects were moved around in ways which can't be
+        // tracked. Followed by an Insert for every object of the type which
+        // exists in the new version.
+        Clear,
+    };
+
+    struct PropertyValue {
+        std::string name;
+        ChangeValue value;
+    };
+
+    Kind kind;
+    std::string object_type;
+    // The object's primary key, which is null if its type has no primary key
+    // and for Clear
+    ChangeValue primary_key;
+    // The index of the object's row in the new version for Insert and Modify,
+    // and in the old version for Delete. Row indices change as objects are
+    // deleted, so this only identifies objects of types without a primary key
+    // within a single version.
+    size_t row_ndx = npos;
+    std::vector<PropertyValue> values;
+};
+
+// Reads the changes made to a Realm file as a stream of object-level changes.
+// The changes are found by replaying the transaction logs between two versions
+// rather than by comparing the contents of the tables, so reading the changes
+// made since the last read costs time proportional to the number of changes
+// rather than to the size of the Realm.
+//
+// The changes from all of the commits between the two versions are coalesced,
+// so an object which was inserted and then modified is reported once as an
+// insertion with its final values, and one which was inserted and then
+// deleted isn't reported at all.
+//
+// The stream holds a read transaction at the version it has read up to, which
+// is what keeps the transaction logs after that version available, but which
+// also keeps the space used by later versions from being reused. A stream
+// which isn't read from regularly makes the file grow.
+//
+// Reading across a schema change which open Realm instances would have to
+// reject, such as a migration, throws the same error as advancing a Realm.
+class ChangeStream {
+public:
+    // Open a stream starting at the latest version of the Realm file at
+    // config.path
+    ChangeStream(Realm::Config const& config);
+    // Open a stream starting at the given version, which has to still be
+    // available because something holds a read transaction for it. Throws
+    // SharedGroup::BadVersion otherwise.
+    ChangeStream(Realm::Config const& config, SharedGroup::VersionID version);
+    ~ChangeStream();
+
+    // The version the stream has read up to
+    SharedGroup::VersionID version() const;
+
+    // Read the changes from version() to the given version, or to the latest
+    // version if none is given, and move the stream to that version. Changes
+    // to each type are ordered by deletions, then modifications, then
+    // insertions. If reading fails the stream stays at its current version.
+    std::vector<ObjectChange> read(SharedGroup::VersionID version = SharedGroup::VersionID());
+
+    // Read the changes as with read() and append them to the file at `path`,
+    // creating it if needed, with one JSON object per line:
+    // {"version":12,"kind":"modify","type":"Person","primaryKey":"x","row":3,"values":{"age":30}}
+    // Data values are base64-encoded, dates are seconds since 1970, and links
+    // are the primary keys of the linked objects. Returns the number of
+    // changes written. If writing fails the stream stays at its current
+    // version, so that the changes are written by the next call.
+    size_t append_to_file(std::string const& path, SharedGroup::VersionID version = SharedGroup::VersionID());
+
+private:
+    Realm::Config m_config;
+
+    // The stream's read transaction, which is advanced by each read
+    std::unique_ptr<ClientHistory> m_history;
+    std::unique_ptr<SharedGroup> m_shared_group;
+    Group* m_group = nullptr;
+    // A second SharedGroup for reading deleted objects from the old version
+    // while m_shared_group is advanced, created the first time it's needed
+    std::unique_ptr<ClientHistory> m_old_history;
+    std::unique_ptr<SharedGroup> m_old_shared_group;
+
+    std::unique_ptr<SharedGroup> open(std::unique_ptr<ClientHistory>& history) const;
+
+    // Read the changes as with read() and pass them to `consume` before ending
+    // the read transaction for the old version. If `consume` throws the stream
+    // is moved back to the old version.
+    std::vector<ObjectChange> read(SharedGroup::VersionID version,
+                                   std::function<void(std::vector<ObjectChange> const&)> const& consume);
+};
+} // namespace realm
+
+#endif /* REALM_CHANGE_STREAM_HPP */
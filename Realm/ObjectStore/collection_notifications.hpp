@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_COLLECTION_NOTIFICATIONS_HPP
+#define REALM_COLLECTION_NOTIFICATIONS_HPP
+
+#include "index_set.hpp"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace realm {
+namespace _impl {
+class ResultsNotifier;
+}
+
+// The changes made to the rows in a collection between two versions of the
+// Realm. Deletions are indices in the old version of the collection, while
+// insertions and modifications are indices in the new version.
+struct CollectionChangeSet {
+    struct Move {
+        size_t from;
+        size_t to;
+    };
+
+    IndexSet deletions;
+    IndexSet insertions;
+    IndexSet modifications;
+
+    // Rows which are still in the collection but at a different position. The
+    // `from` index of each move is also in deletions, and the `to` index is
+    // also in insertions, so bindings which can't represent moves can ignore
+    // them.
+    std::vector<Move> moves;
+
+    bool empty() const noexcept
+    {
+        return deletions.empty() && insertions.empty() && modifications.empty() && moves.empty();
+    }
+};
+
+using CollectionChangeCallback = std::function<void (CollectionChangeSet const&)>;
+
+// A token returned when registering a change callback, which keeps the callback
+// registered until it's destroyed. Must be destroyed on the thread which the
+// callback was registered on.
+class NotificationToken {
+public:
+    NotificationToken() = default;
+    NotificationToken(std::shared_ptr<_impl::ResultsNotifier> notifier);
+    ~NotificationToken();
+
+    NotificationToken(NotificationToken&&) = default;
+    NotificationToken& operator=(NotificationToken&&);
+
+    NotificationToken(NotificationToken const&) = delete;
+    NotificationToken& operator=(NotificationToken const&) = delete;
+
+private:
+    std::shared_ptr<_impl::ResultsNotifier> m_notifier;
+};
+} // namespace realm
+
+#endif /* REALM_COLLECTION_NOTIFICATIONS_HPP */
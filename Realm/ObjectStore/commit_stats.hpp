@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_COMMIT_STATS_HPP
+#define REALM_COMMIT_STATS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace realm {
+// What a single write transaction did, gathered from its transaction log when
+// it's committed if Realm::Config::record_commit_stats is set.
+struct CommitStats {
+    // The changes made to the rows of a single table. Row counts are of
+    // instructions rather than distinct rows, so a row which is set several
+    // times counts once for each.
+    struct TableStats {
+        size_t rows_inserted = 0;
+        size_t rows_erased = 0;
+        // Fields of existing rows which were set, including substring edits
+        size_t values_set = 0;
+        // Insertions, removals, moves and other changes to the LinkLists of
+        // rows in the table
+        size_t link_list_operations = 0;
+        // Size of the values written by string and binary assignments
+        size_t string_bytes = 0;
+        size_t binary_bytes = 0;
+        // Was the table cleared? The number of rows removed isn't recorded in
+        // the transaction log, so they're not included in rows_erased.
+        bool cleared = false;
+
+        TableStats& operator+=(TableStats const& other) noexcept
+        {
+            rows_inserted += other.rows_inserted;
+            rows_erased += other.rows_erased;
+            values_set += other.values_set;
+            link_list_operations += other.link_list_operations;
+            string_bytes += other.string_bytes;
+            binary_bytes += other.binary_bytes;
+            cleared = cleared || other.cleared;
+            return *this;
+        }
+    };
+
+    // The version of the Realm file produced by the commit
+    uint64_t version = 0;
+    // Size of the commit's transaction log in bytes
+    size_t transaction_log_size = 0;
+    // Number of schema changes, such as added tables, columns and indexes
+    size_t schema_changes = 0;
+    // Indexed by the tables' indices as of the end of the commit, and only as
+    // long as needed to hold the last modified table
+    std::vector<TableStats> tables;
+
+    // The sum of the stats for every table
+    TableStats totals() const noexcept
+    {
+        TableStats total;
+        for (auto const& table : tables) {
+            total += table;
+        }
+        return total;
+    }
+};
+} // namespace realm
+
+#endif /* REALM_COMMIT_STATS_HPP */
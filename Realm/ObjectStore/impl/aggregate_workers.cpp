@@ -0,0 +1,338 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "aggregate_workers.hpp"
+
+#include <realm/commit_log.hpp>
+#include <realm/datetime.hpp>
+#include <realm/table.hpp>
+#include <realm/util/optional.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+
+using namespace realm;
+using namespace realm::_impl;
+
+struct AggregateWorkers::Job {
+    SharedGroup::VersionID version;
+    size_t table_ndx;
+    size_t chunk_count;
+    std::function<void(Table const&, size_t)> func;
+
+    // Guarded by the pool's mutex
+    size_t next_chunk = 0;
+    size_t remaining;
+    std::exception_ptr error;
+    std::condition_variable done;
+};
+
+std::shared_ptr<AggregateWorkers> AggregateWorkers::get(Realm::Config const& config)
+{
+    static std::mutex s_mutex;
+    static auto& s_workers = *new std::unordered_map<std::string, std::weak_ptr<AggregateWorkers>>;
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    auto& weak_workers = s_workers[config.path];
+    auto workers = weak_workers.lock();
+    if (!workers) {
+        workers = std::make_shared<AggregateWorkers>(config);
+        weak_workers = workers;
+    }
+    return workers;
+}
+
+AggregateWorkers::AggregateWorkers(Realm::Config const& config)
+: m_path(config.path)
+, m_encryption_key(config.encryption_key)
+, m_in_memory(config.in_memory)
+{
+    m_threads.reserve(config.aggregate_threads);
+    for (size_t i = 0; i < config.aggregate_threads; ++i) {
+        m_threads.emplace_back([this] { work(); });
+    }
+}
+
+AggregateWorkers::~AggregateWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cv.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void AggregateWorkers::run(SharedGroup::VersionID version, size_t table_ndx, Table const& local_table,
+                           size_t chunk_count, std::function<void(Table const&, size_t)> func)
+{
+    if (chunk_count == 0) {
+        return;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->version = version;
+    job->table_ndx = table_ndx;
+    job->chunk_count = chunk_count;
+    job->func = std::move(func);
+    job->remaining = chunk_count;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(job);
+    }
+    m_cv.notify_all();
+
+    // Work on the job on this thread too rather than only waiting for it
+    while (true) {
+        size_t chunk;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!take_chunk(*job, chunk)) {
+                break;
+            }
+        }
+        run_chunk(*job, local_table, chunk);
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    job->done.wait(lock, [&] { return job->remaining == 0; });
+    if (job->error) {
+        std::rethrow_exception(job->error);
+    }
+}
+
+bool AggregateWorkers::take_chunk(Job& job, size_t& chunk)
+{
+    if (job.next_chunk == job.chunk_count) {
+        return false;
+    }
+    chunk = job.next_chunk++;
+    if (job.next_chunk == job.chunk_count) {
+        auto it = std::find_if(m_queue.begin(), m_queue.end(), [&](auto const& queued) { return queued.get() == &job; });
+        if (it != m_queue.end()) {
+            m_queue.erase(it);
+        }
+    }
+    return true;
+}
+
+void AggregateWorkers::run_chunk(Job& job, Table const& table, size_t chunk)
+{
+    std::exception_ptr error;
+    try {
+        job.func(table, chunk);
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+    finish_chunk(job, error);
+}
+
+void AggregateWorkers::finish_chunk(Job& job, std::exception_ptr error)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (error && !job.error) {
+        job.error = error;
+    }
+    if (--job.remaining == 0) {
+        job.done.notify_all();
+    }
+}
+
+void AggregateWorkers::work()
+{
+    // The SharedGroup used by this thread, which is created the first time
+    // it's needed and only has a read transaction while there are jobs
+    std::unique_ptr<ClientHistory> history;
+    std::unique_ptr<SharedGroup> shared_group;
+    Group const* group = nullptr;
+    SharedGroup::VersionID read_version;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        if (m_queue.empty() && group) {
+            lock.unlock();
+            shared_group->end_read();
+            group = nullptr;
+            lock.lock();
+            continue;
+        }
+        m_cv.wait(lock, [&] { return m_stopping || !m_queue.empty(); });
+        if (m_stopping) {
+            break;
+        }
+
+        // Jobs are removed from the queue when their last chunk is taken, so
+        // the first one always has one left
+        auto job = m_queue.front();
+        size_t chunk;
+        take_chunk(*job, chunk);
+        lock.unlock();
+
+        ConstTableRef table;
+        try {
+            if (!shared_group) {
+                history = realm::make_client_history(m_path, m_encryption_key.data());
+                SharedGroup::DurabilityLevel durability = m_in_memory ? SharedGroup::durability_MemOnly :
+                                                                        SharedGroup::durability_Full;
+                shared_group = std::make_unique<SharedGroup>(*history, durability, m_encryption_key.data(), false);
+            }
+            if (group && (read_version.version != job->version.version || read_version.index != job->version.index)) {
+                shared_group->end_read();
+                group = nullptr;
+            }
+            if (!group) {
+                // The submitting thread holds a read transaction at the job's
+                // version until the job is done, so it can't have been
+                // cleaned up
+                group = &shared_group->begin_read(job->version);
+                read_version = job->version;
+            }
+            table = group->get_table(job->table_ndx);
+        }
+        catch (...) {
+            finish_chunk(*job, std::current_exception());
+            lock.lock();
+            continue;
+        }
+
+        run_chunk(*job, *table, chunk);
+        lock.lock();
+    }
+
+    lock.unlock();
+    if (group) {
+        shared_group->end_read();
+    }
+}
+
+namespace {
+template<typename T> T get(Table const& table, size_t col, size_t row);
+template<> int64_t get(Table const& table, size_t col, size_t row) { return table.get_int(col, row); }
+template<> float get(Table const& table, size_t col, size_t row) { return table.get_float(col, row); }
+template<> double get(Table const& table, size_t col, size_t row) { return table.get_double(col, row); }
+template<> DateTime get(Table const& table, size_t col, size_t row) { return table.get_datetime(col, row); }
+} // anonymous namespace
+
+ParallelAggregates::ParallelAggregates(AggregateWorkers& workers, SharedGroup::VersionID version,
+                                       Table const& table, std::vector<size_t> const* rows)
+: m_workers(workers)
+, m_version(version)
+, m_table(table)
+, m_rows(rows)
+, m_size(rows ? rows->size() : table.size())
+{
+    // Use a few chunks per thread so that a thread which is slow to start
+    // (or which has other work) doesn't hold up the rest of them
+    size_t max_chunks = (workers.thread_count() + 1) * 4;
+    m_chunk_count = std::max<size_t>(1, std::min(m_size / min_chunk_size, max_chunks));
+    m_chunk_size = (m_size + m_chunk_count - 1) / m_chunk_count;
+}
+
+void ParallelAggregates::run(std::function<void(Table const&, size_t)> func) const
+{
+    m_workers.run(m_version, m_table.get_index_in_group(), m_table, m_chunk_count, std::move(func));
+}
+
+template<typename T, typename Func>
+void ParallelAggregates::for_each(Table const& table, size_t chunk, size_t col, Func&& func) const
+{
+    size_t begin = chunk * m_chunk_size;
+    size_t end = std::min(begin + m_chunk_size, m_size);
+    bool nullable = table.is_nullable(col);
+    for (size_t i = begin; i < end; ++i) {
+        size_t row = m_rows ? (*m_rows)[i] : i;
+        if (!nullable || !table.is_null(col, row)) {
+            func(get<T>(table, col, row));
+        }
+    }
+}
+
+template<typename T>
+T ParallelAggregates::extreme(size_t col, bool maximum) const
+{
+    auto better = [=](T const& a, T const& b) { return maximum ? b < a : a < b; };
+
+    std::vector<util::Optional<T>> results(m_chunk_count);
+    run([&](Table const& table, size_t chunk) {
+        util::Optional<T> result;
+        for_each<T>(table, chunk, col, [&](T value) {
+            if (!result || better(value, *result)) {
+                result = value;
+            }
+        });
+        results[chunk] = result;
+    });
+
+    util::Optional<T> result;
+    for (auto const& chunk_result : results) {
+        if (chunk_result && (!result || better(*chunk_result, *result))) {
+            result = chunk_result;
+        }
+    }
+    return result ? *result : T();
+}
+
+DateTime ParallelAggregates::maximum_datetime(size_t col) const
+{
+    return extreme<DateTime>(col, true);
+}
+
+DateTime ParallelAggregates::minimum_datetime(size_t col) const
+{
+    return extreme<DateTime>(col, false);
+}
+
+template<typename Sum, typename T>
+Sum ParallelAggregates::sum(size_t col) const
+{
+    std::vector<Sum> results(m_chunk_count);
+    run([&](Table const& table, size_t chunk) {
+        Sum result = 0;
+        for_each<T>(table, chunk, col, [&](T value) { result += value; });
+        results[chunk] = result;
+    });
+    return std::accumulate(results.begin(), results.end(), Sum(0));
+}
+
+template<typename T>
+double ParallelAggregates::average(size_t col) const
+{
+    std::vector<std::pair<double, size_t>> results(m_chunk_count);
+    run([&](Table const& table, size_t chunk) {
+        double sum = 0;
+        size_t count = 0;
+        for_each<T>(table, chunk, col, [&](T value) {
+            sum += value;
+            ++count;
+        });
+        results[chunk] = {sum, count};
+    });
+
+    double sum = 0;
+    size_t count = 0;
+    for (auto const& chunk_result : results) {
+        sum += chunk_result.first;
+        count += chunk_result.second;
+    }
+    return count ? sum / count : 0;
+}
@@ -0,0 +1,164 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_AGGREGATE_WORKERS_HPP
+#define REALM_AGGREGATE_WORKERS_HPP
+
+#include "shared_realm.hpp"
+
+#include <realm/group_shared.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace realm {
+class DateTime;
+class Table;
+
+namespace _impl {
+// A pool of threads which evaluate a function over the chunks of a job in
+// parallel, each with its own SharedGroup for the Realm file with a read
+// transaction at the version the job was submitted at. The submitting thread
+// works on the job's chunks too, using its own accessor for the table, so a
+// pool of N threads evaluates a job on up to N + 1 cores.
+//
+// The worker threads only hold read transactions while they have a job to
+// work on, so an idle pool doesn't keep old versions of the file alive.
+class AggregateWorkers {
+public:
+    // Get the pool for the config's path, which is shared by every Realm
+    // instance for the path in this process. It has as many threads as the
+    // aggregate_threads of the config which first created it.
+    static std::shared_ptr<AggregateWorkers> get(Realm::Config const& config);
+
+    AggregateWorkers(Realm::Config const& config);
+    ~AggregateWorkers();
+
+    size_t thread_count() const noexcept { return m_threads.size(); }
+
+    // Call `func(table, chunk)` for each chunk in [0, chunk_count), with
+    // `table` an accessor for the table at `table_ndx` in the Realm at
+    // `version`. `local_table` is used for the chunks evaluated on the calling
+    // thread, which must have a read transaction at `version` for the
+    // duration of the call. Blocks until every chunk has been evaluated, and
+    // rethrows the first exception thrown by `func` if there were any.
+    void run(SharedGroup::VersionID version, size_t table_ndx, Table const& local_table,
+             size_t chunk_count, std::function<void(Table const&, size_t)> func);
+
+private:
+    struct Job;
+
+    std::string m_path;
+    std::vector<char> m_encryption_key;
+    bool m_in_memory;
+
+    // Guards everything below
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    // Jobs which still have chunks which no thread has started on
+    std::deque<std::shared_ptr<Job>> m_queue;
+    bool m_stopping = false;
+
+    std::vector<std::thread> m_threads;
+
+    void work();
+
+    // Take the next chunk of `job`, or return false if every chunk has been
+    // taken. Must be called with m_mutex held.
+    bool take_chunk(Job& job, size_t& chunk);
+    // Evaluate a chunk of `job` and record that it's done
+    void run_chunk(Job& job, Table const& table, size_t chunk);
+    // Record that a chunk of `job` is done, and that it failed if `error` is
+    // non-null
+    void finish_chunk(Job& job, std::exception_ptr error);
+
+    AggregateWorkers(AggregateWorkers const&) = delete;
+    AggregateWorkers& operator=(AggregateWorkers const&) = delete;
+};
+
+// Aggregates over the rows of a table, with the same interface as Table's and
+// TableView's so that Results::aggregate()'s getters can use it, which
+// splits the rows into chunks evaluated on an AggregateWorkers pool and then
+// combines the chunks' results. Null values are skipped, as they are by core.
+class ParallelAggregates {
+public:
+    // The rows are `rows` if non-null, and otherwise every row of the table.
+    // `table` must be an accessor on the calling thread for a table in a
+    // Realm whose read transaction is at `version`.
+    ParallelAggregates(AggregateWorkers& workers, SharedGroup::VersionID version,
+                       Table const& table, std::vector<size_t> const* rows);
+
+    // The minimum number of rows for it to be worth splitting an aggregate
+    // between threads, as each chunk has the overhead of waking a thread and
+    // of it beginning a read transaction
+    static const size_t min_chunk_size = 64 * 1024;
+
+    int64_t maximum_int(size_t col) const { return extreme<int64_t>(col, true); }
+    float maximum_float(size_t col) const { return extreme<float>(col, true); }
+    double maximum_double(size_t col) const { return extreme<double>(col, true); }
+    DateTime maximum_datetime(size_t col) const;
+
+    int64_t minimum_int(size_t col) const { return extreme<int64_t>(col, false); }
+    float minimum_float(size_t col) const { return extreme<float>(col, false); }
+    double minimum_double(size_t col) const { return extreme<double>(col, false); }
+    DateTime minimum_datetime(size_t col) const;
+
+    int64_t sum_int(size_t col) const { return sum<int64_t, int64_t>(col); }
+    double sum_float(size_t col) const { return sum<double, float>(col); }
+    double sum_double(size_t col) const { return sum<double, double>(col); }
+
+    double average_int(size_t col) const { return average<int64_t>(col); }
+    double average_float(size_t col) const { return average<float>(col); }
+    double average_double(size_t col) const { return average<double>(col); }
+
+private:
+    AggregateWorkers& m_workers;
+    SharedGroup::VersionID m_version;
+    Table const& m_table;
+    std::vector<size_t> const* m_rows;
+    size_t m_size;
+    size_t m_chunk_size;
+    size_t m_chunk_count;
+
+    // Call `func(table, chunk)` for each chunk on the workers
+    void run(std::function<void(Table const&, size_t)> func) const;
+
+    // Call `func(value)` for each non-null value in the given column of the
+    // rows in the given chunk
+    template<typename T, typename Func>
+    void for_each(Table const& table, size_t chunk, size_t col, Func&& func) const;
+
+    template<typename T>
+    T extreme(size_t col, bool maximum) const;
+    template<typename Sum, typename T>
+    Sum sum(size_t col) const;
+    template<typename T>
+    double average(size_t col) const;
+};
+} // namespace _impl
+} // namespace realm
+
+#endif /* REALM_AGGREGATE_WORKERS_HPP */
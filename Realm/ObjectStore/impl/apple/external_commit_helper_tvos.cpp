@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "external_commit_helper.hpp"
+
+#if TARGET_OS_TV
+#include "shared_realm.hpp"
+
+#include <algorithm>
+#include <dispatch/dispatch.h>
+
+using namespace realm;
+using namespace realm::_impl;
+
+// tvOS doesn't allow named pipes, so only Realm instances within the current
+// process can be notified, which can be done directly from notify_others()
+// without any background thread. Notifications which have to wait for a
+// Realm's minimum notification interval are delivered via a dispatch timer.
+ExternalCommitHelper::ExternalCommitHelper(Realm* realm)
+: m_realms(m_commit_counter)
+{
+    add_realm(realm);
+}
+
+ExternalCommitHelper::~ExternalCommitHelper()
+{
+}
+
+void ExternalCommitHelper::notify_others(uint64_t version)
+{
+    m_commit_counter.commit(version);
+    schedule_timer(m_realms.notify_realms(m_commit_counter.version()));
+}
+
+void ExternalCommitHelper::on_timer()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_timer_mutex);
+        m_next_timer = clock::time_point::max();
+    }
+    schedule_timer(m_realms.notify_pending());
+}
+
+void ExternalCommitHelper::schedule_timer(clock::time_point when)
+{
+    std::lock_guard<std::mutex> lock(m_timer_mutex);
+    // An earlier timer is already scheduled, which will schedule this one
+    // when it fires if it's still needed
+    if (when >= m_next_timer) {
+        return;
+    }
+    m_next_timer = when;
+
+    auto delay = std::chrono::duration_cast<std::chrono::nanoseconds>(when - clock::now()).count();
+    // The helper may be destroyed before the timer fires
+    auto weak_self = new std::weak_ptr<ExternalCommitHelper>(shared_from_this());
+    dispatch_after_f(dispatch_time(DISPATCH_TIME_NOW, std::max<int64_t>(delay, 0)),
+                     dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),
+                     weak_self, [](void* context) {
+        auto weak_self = static_cast<std::weak_ptr<ExternalCommitHelper>*>(context);
+        if (auto self = weak_self->lock()) {
+            self->on_timer();
+        }
+        delete weak_self;
+    });
+}
+#endif
@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include <TargetConditionals.h>
+
+// tvOS doesn't allow named pipes, so there's nothing to poll there
+#if !TARGET_OS_TV
+#include "notifier_thread.hpp"
+
+#include <algorithm>
+#include <assert.h>
+#include <sys/event.h>
+#include <sys/time.h>
+#include <system_error>
+
+using namespace realm;
+using namespace realm::_impl;
+
+// kqueue() lets us efficiently wait until the amount of data which can be read
+// from one or more file descriptors has changed, and tells us which of the file
+// descriptors it was that changed.
+FdPoller::FdPoller()
+{
+    m_fd = kqueue();
+    if (m_fd == -1) {
+        throw std::system_error(errno, std::system_category());
+    }
+}
+
+void FdPoller::add(int fd, uintptr_t token)
+{
+    // EVFILT_READ indicates that we care about data being available to read
+    // on the given file descriptor.
+    // EV_CLEAR makes it wait for the amount of data available to be read to
+    // change rather than just returning when there is any data to read.
+    struct kevent ke;
+    EV_SET(&ke, fd, EVFILT_READ, EV_ADD | EV_CLEAR, 0, 0, reinterpret_cast<void*>(token));
+    if (kevent(m_fd, &ke, 1, nullptr, 0, nullptr) == -1) {
+        throw std::system_error(errno, std::system_category());
+    }
+}
+
+void FdPoller::remove(int fd)
+{
+    struct kevent ke;
+    EV_SET(&ke, fd, EVFILT_READ, EV_DELETE, 0, 0, 0);
+    kevent(m_fd, &ke, 1, nullptr, 0, nullptr);
+}
+
+void FdPoller::wait(std::chrono::steady_clock::time_point deadline, std::vector<uintptr_t>& tokens)
+{
+    struct timespec timeout;
+    struct timespec* timeout_ptr = nullptr;
+    if (deadline != std::chrono::steady_clock::time_point::max()) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - std::chrono::steady_clock::now()).count();
+        ns = std::max<int64_t>(ns, 0);
+        timeout.tv_sec = ns / 1000000000;
+        timeout.tv_nsec = ns % 1000000000;
+        timeout_ptr = &timeout;
+    }
+
+    struct kevent events[16];
+    // Return code is number of events read or -1 on error
+    int ret = kevent(m_fd, nullptr, 0, events, 16, timeout_ptr);
+    assert(ret >= 0 || errno == EINTR);
+
+    for (int i = 0; i < ret; ++i) {
+        tokens.push_back(reinterpret_cast<uintptr_t>(events[i].udata));
+    }
+}
+#endif
@@ -0,0 +1,125 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "scheduler.hpp"
+
+#include <CoreFoundation/CoreFoundation.h>
+
+using namespace realm;
+
+namespace {
+// When a Realm is created, we add a CFRunLoopSource to the current thread's
+// runloop. On each cycle of the run loop, the run loop checks each of its
+// sources for work to do, which in the case of CFRunLoopSource is just
+// checking if CFRunLoopSourceSignal has been called since the last time it
+// ran, and if so invokes the function pointer supplied when the source is
+// created, which in our case delivers the notification to the Realm.
+class RunLoopScheduler : public Scheduler, public std::enable_shared_from_this<RunLoopScheduler> {
+public:
+    RunLoopScheduler();
+    ~RunLoopScheduler();
+
+    void init();
+
+    bool is_on_thread() const noexcept override { return CFRunLoopGetCurrent() == m_runloop; }
+    bool can_deliver() const noexcept override;
+
+protected:
+    void do_notify() override;
+
+private:
+    CFRunLoopRef m_runloop;
+    CFRunLoopSourceRef m_signal = nullptr;
+};
+
+RunLoopScheduler::RunLoopScheduler()
+: m_runloop(CFRunLoopGetCurrent())
+{
+    CFRetain(m_runloop);
+}
+
+void RunLoopScheduler::init()
+{
+    // The source may outlive the scheduler if the scheduler is destroyed on a
+    // different thread while the source is being performed, so it holds a
+    // refcounted weak pointer to the scheduler rather than a raw pointer
+    struct RefCountedWeakPointer {
+        std::weak_ptr<RunLoopScheduler> scheduler;
+        std::atomic<size_t> ref_count = {1};
+    };
+
+    CFRunLoopSourceContext ctx{};
+    ctx.info = new RefCountedWeakPointer{shared_from_this()};
+    ctx.perform = [](void* info) {
+        if (auto scheduler = static_cast<RefCountedWeakPointer*>(info)->scheduler.lock()) {
+            scheduler->deliver();
+        }
+    };
+    ctx.retain = [](const void* info) {
+        static_cast<RefCountedWeakPointer*>(const_cast<void*>(info))->ref_count.fetch_add(1, std::memory_order_relaxed);
+        return info;
+    };
+    ctx.release = [](const void* info) {
+        auto ptr = static_cast<RefCountedWeakPointer*>(const_cast<void*>(info));
+        if (ptr->ref_count.fetch_add(-1, std::memory_order_acq_rel) == 1) {
+            delete ptr;
+        }
+    };
+
+    m_signal = CFRunLoopSourceCreate(kCFAllocatorDefault, 0, &ctx);
+    CFRunLoopAddSource(m_runloop, m_signal, kCFRunLoopDefaultMode);
+    // CFRunLoopSourceCreate() retained the context, so drop our initial reference
+    ctx.release(ctx.info);
+}
+
+RunLoopScheduler::~RunLoopScheduler()
+{
+    if (m_signal) {
+        CFRunLoopSourceInvalidate(m_signal);
+        CFRelease(m_signal);
+    }
+    CFRelease(m_runloop);
+}
+
+bool RunLoopScheduler::can_deliver() const noexcept
+{
+    // The run loop always exists, but if it isn't running then the source
+    // will never be performed
+    if (CFStringRef mode = CFRunLoopCopyCurrentMode(m_runloop)) {
+        CFRelease(mode);
+        return true;
+    }
+    return false;
+}
+
+void RunLoopScheduler::do_notify()
+{
+    CFRunLoopSourceSignal(m_signal);
+    // Signalling the source makes it run the next time the runloop gets
+    // to it, but doesn't make the runloop start if it's currently idle
+    // waiting for events
+    CFRunLoopWakeUp(m_runloop);
+}
+} // anonymous namespace
+
+std::shared_ptr<Scheduler> Scheduler::make_default()
+{
+    auto scheduler = std::make_shared<RunLoopScheduler>();
+    scheduler->init();
+    return scheduler;
+}
@@ -0,0 +1,175 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "background_writer.hpp"
+
+#include "scheduler.hpp"
+
+#include <realm/group_shared.hpp>
+
+#include <unordered_map>
+
+using namespace realm;
+using namespace realm::_impl;
+
+std::shared_ptr<BackgroundWriter> BackgroundWriter::get(Realm::Config const& config)
+{
+    static std::mutex s_mutex;
+    static auto& s_writers = *new std::unordered_map<std::string, std::weak_ptr<BackgroundWriter>>;
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    auto& weak_writer = s_writers[config.path];
+    auto writer = weak_writer.lock();
+    if (!writer) {
+        writer = std::make_shared<BackgroundWriter>(config);
+        weak_writer = writer;
+    }
+    return writer;
+}
+
+BackgroundWriter::BackgroundWriter(Realm::Config config)
+: m_config(std::move(config))
+{
+    // The writer's Realm is private to it and never delivers notifications
+    m_config.cache = false;
+    m_config.scheduler = nullptr;
+    m_config.calculate_changes_in_background = false;
+    m_config.record_notification_metrics = false;
+    m_config.group_commit = false;
+
+    m_thread = std::thread([this] { run(); });
+}
+
+BackgroundWriter::~BackgroundWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cv.notify_one();
+
+    // The thread finishes the writes already queued before exiting. Completion
+    // callbacks must not hold the last reference to the writer, as it can't
+    // wait for its own thread.
+    REALM_ASSERT(m_thread.get_id() != std::this_thread::get_id());
+    m_thread.join();
+}
+
+void BackgroundWriter::enqueue(Write write, Completion completion)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back({std::move(write), std::move(completion)});
+    }
+    m_cv.notify_one();
+}
+
+void BackgroundWriter::run()
+{
+    SharedRealm realm;
+    std::exception_ptr open_error;
+    try {
+        auto config = m_config;
+        config.scheduler = ExecutorScheduler::make([](std::function<void()>) { });
+        realm = Realm::get_shared_realm(std::move(config));
+        realm->set_auto_refresh(false);
+    }
+    catch (...) {
+        open_error = std::current_exception();
+    }
+
+    std::vector<QueuedWrite> writes;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [&] { return m_stopping || !m_queue.empty(); });
+            if (m_queue.empty()) {
+                return;
+            }
+            writes.swap(m_queue);
+        }
+
+        if (realm) {
+            commit(*realm, writes);
+        }
+        else {
+            for (auto& write : writes) {
+                write.completion(open_error, {});
+            }
+        }
+        writes.clear();
+    }
+}
+
+void BackgroundWriter::commit(Realm& realm, std::vector<QueuedWrite>& writes)
+{
+    size_t pending = writes.size();
+    while (pending > 0) {
+        size_t failed = npos;
+        std::exception_ptr error;
+        SharedGroup::VersionID version;
+        try {
+            realm.begin_transaction();
+            for (size_t i = 0; i < pending; ++i) {
+                try {
+                    writes[i].write(realm);
+                }
+                catch (...) {
+                    failed = i;
+                    error = std::current_exception();
+                    break;
+                }
+            }
+            if (failed != npos) {
+                realm.cancel_transaction();
+            }
+            else {
+                realm.commit_transaction();
+                version = realm.read_transaction_version();
+            }
+        }
+        catch (...) {
+            // Beginning, committing or cancelling the transaction failed, so
+            // none of the writes were made
+            auto commit_error = std::current_exception();
+            try {
+                if (realm.is_in_transaction()) {
+                    realm.cancel_transaction();
+                }
+            }
+            catch (...) {
+            }
+            for (size_t i = 0; i < pending; ++i) {
+                writes[i].completion(commit_error, {});
+            }
+            return;
+        }
+
+        if (failed == npos) {
+            for (size_t i = 0; i < pending; ++i) {
+                writes[i].completion(nullptr, version);
+            }
+            return;
+        }
+
+        // Fail only the write which threw and run the rest again without it
+        writes[failed].completion(error, {});
+        std::move(writes.begin() + failed + 1, writes.begin() + pending, writes.begin() + failed);
+        --pending;
+    }
+}
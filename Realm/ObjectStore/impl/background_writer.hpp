@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_BACKGROUND_WRITER_HPP
+#define REALM_BACKGROUND_WRITER_HPP
+
+#include "shared_realm.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace realm {
+namespace _impl {
+// Runs write transactions for a Realm file on a dedicated thread which has its
+// own Realm instance, so that the threads which queue the writes never wait
+// on the write lock themselves.
+//
+// All of the writes which are queued while a commit is in progress are run
+// together in the next write transaction, so many small writes from different
+// threads pay for a single durable commit and a single notification of other
+// Realm instances rather than one each. If a write throws, the transaction is
+// rolled back and the other writes in it are run again in a new transaction,
+// so writes may be run more than once and must not have side effects other
+// than their changes to the Realm.
+class BackgroundWriter {
+public:
+    using Write = std::function<void(Realm&)>;
+    // Called on the writer thread once the write is complete, with the version
+    // produced by the commit which included it, or the exception thrown by the
+    // write or by committing it
+    using Completion = std::function<void(std::exception_ptr error, SharedGroup::VersionID version)>;
+
+    // Get the writer for the Realm file at config.path, creating it if needed.
+    // The writer's Realm is opened with the given config when it's created.
+    static std::shared_ptr<BackgroundWriter> get(Realm::Config const& config);
+
+    BackgroundWriter(Realm::Config config);
+    ~BackgroundWriter();
+
+    void enqueue(Write write, Completion completion);
+
+private:
+    struct QueuedWrite {
+        Write write;
+        Completion completion;
+    };
+
+    Realm::Config m_config;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<QueuedWrite> m_queue;
+    bool m_stopping = false;
+
+    std::thread m_thread;
+
+    void run();
+    // Run the given writes in as few write transactions as possible and
+    // complete them
+    static void commit(Realm& realm, std::vector<QueuedWrite>& writes);
+};
+} // namespace _impl
+} // namespace realm
+
+#endif /* REALM_BACKGROUND_WRITER_HPP */
@@ -0,0 +1,252 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "change_calculator.hpp"
+
+#include "transact_log_handler.hpp"
+
+#include <realm/commit_log.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+using namespace realm;
+using namespace realm::_impl;
+
+namespace {
+// A single background thread shared by all ChangeCalculators, which runs the
+// functions added to it in order
+class WorkerThread {
+public:
+    static WorkerThread& shared()
+    {
+        // Intentionally leaked as the thread never exits
+        static WorkerThread& thread = *new WorkerThread;
+        return thread;
+    }
+
+    void add(std::function<void()> fn)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(std::move(fn));
+        m_cv.notify_one();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::function<void()>> m_queue;
+
+    WorkerThread()
+    {
+        std::thread([this] { run(); }).detach();
+    }
+
+    void run()
+    {
+        while (true) {
+            std::function<void()> fn;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [&] { return !m_queue.empty(); });
+                fn = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+            fn();
+        }
+    }
+};
+
+// A BindingContext which reports a fixed set of observed rows and captures
+// the changes calculated for them
+class CapturingContext : public BindingContext {
+public:
+    CapturingContext(std::vector<ObserverState> observers) : m_observers(std::move(observers)) { }
+
+    std::vector<ObserverState> get_observed_rows() override { return std::move(m_observers); }
+    void will_change(std::vector<ObserverState> const&, std::vector<void*> const&) override { }
+    void did_change(std::vector<ObserverState> const& observers, std::vector<void*> const& invalidated) override
+    {
+        m_observers = observers;
+        m_invalidated = invalidated;
+    }
+
+    std::vector<ObserverState> m_observers;
+    std::vector<void*> m_invalidated;
+};
+
+bool same_observers(std::vector<BindingContext::ObserverState> const& a,
+                    std::vector<BindingContext::ObserverState> const& b)
+{
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](auto const& a, auto const& b) {
+        return a.table_ndx == b.table_ndx && a.row_ndx == b.row_ndx && a.info == b.info;
+    });
+}
+} // anonymous namespace
+
+struct ChangeCalculator::State : public std::enable_shared_from_this<ChangeCalculator::State> {
+    std::mutex mutex;
+    std::function<void()> on_ready;
+
+    // The request currently waiting to be run or running, if any
+    bool pending = false;
+    SharedGroup::VersionID from;
+    std::vector<ObserverState> observers;
+    // A request made while another was running, to be run once it completes
+    bool has_next = false;
+    SharedGroup::VersionID next_from;
+    std::vector<ObserverState> next_observers;
+
+    // The result of the last completed request and the observers it was
+    // requested for, if it hasn't been taken yet
+    bool ready = false;
+    Changes result;
+    std::vector<ObserverState> result_observers;
+
+    // The SharedGroup used for calculating changes, which is only accessed
+    // from the worker thread and is created the first time it's needed
+    std::string path;
+    std::vector<char> encryption_key;
+    bool in_memory;
+    std::unique_ptr<ClientHistory> history;
+    std::unique_ptr<SharedGroup> shared_group;
+
+    void run();
+};
+
+void ChangeCalculator::State::run()
+{
+    SharedGroup::VersionID from_version;
+    std::vector<ObserverState> requested;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        from_version = from;
+        requested = observers;
+    }
+
+    Changes changes;
+    changes.from = from_version;
+    try {
+        if (!shared_group) {
+            history = realm::make_client_history(path, encryption_key.data());
+            SharedGroup::DurabilityLevel durability = in_memory ? SharedGroup::durability_MemOnly :
+                                                                  SharedGroup::durability_Full;
+            shared_group = std::make_unique<SharedGroup>(*history, durability, encryption_key.data(), false);
+        }
+
+        // The owning Realm holds a read transaction for the starting version,
+        // so it can't have been cleaned up unless the Realm has since moved on,
+        // in which case the result won't be used anyway
+        shared_group->begin_read(from_version);
+        CapturingContext context(requested);
+        transaction::advance(*shared_group, *history, &context);
+        changes.to = shared_group->get_version_of_current_transaction();
+        changes.observers = std::move(context.m_observers);
+        changes.invalidated = std::move(context.m_invalidated);
+        shared_group->end_read();
+    }
+    catch (...) {
+        changes.error = std::current_exception();
+        if (shared_group) {
+            shared_group->end_read();
+        }
+    }
+
+    std::function<void()> callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        result = std::move(changes);
+        result_observers = std::move(requested);
+        ready = true;
+        callback = on_ready;
+
+        if (has_next) {
+            has_next = false;
+            from = next_from;
+            observers = std::move(next_observers);
+            WorkerThread::shared().add([self = shared_from_this()] { self->run(); });
+        }
+        else {
+            pending = false;
+        }
+    }
+    if (callback) {
+        callback();
+    }
+}
+
+ChangeCalculator::ChangeCalculator(Realm::Config const& config, std::function<void()> on_ready)
+: m_state(std::make_shared<State>())
+{
+    m_state->on_ready = std::move(on_ready);
+    m_state->path = config.path;
+    m_state->encryption_key = config.encryption_key;
+    m_state->in_memory = config.in_memory;
+}
+
+ChangeCalculator::~ChangeCalculator()
+{
+    // Any calculation currently running keeps the state alive until it
+    // completes, but its result is no longer wanted
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    m_state->on_ready = nullptr;
+    m_state->has_next = false;
+}
+
+void ChangeCalculator::request(SharedGroup::VersionID from, std::vector<ObserverState> observers)
+{
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    auto& state = *m_state;
+
+    if (state.pending && state.from == from && same_observers(state.observers, observers)) {
+        return;
+    }
+    if (state.ready && state.result.from == from && same_observers(state.result_observers, observers)) {
+        return;
+    }
+
+    if (state.pending) {
+        state.has_next = true;
+        state.next_from = from;
+        state.next_observers = std::move(observers);
+        return;
+    }
+
+    state.pending = true;
+    state.from = from;
+    state.observers = std::move(observers);
+    WorkerThread::shared().add([state = m_state] { state->run(); });
+}
+
+bool ChangeCalculator::take(SharedGroup::VersionID from, std::vector<ObserverState> const& observers, Changes& out)
+{
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    auto& state = *m_state;
+    if (!state.ready) {
+        return false;
+    }
+
+    state.ready = false;
+    if (state.result.from != from || !same_observers(state.result_observers, observers)) {
+        return false;
+    }
+    out = std::move(state.result);
+    return true;
+}
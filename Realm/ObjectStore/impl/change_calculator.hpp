@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_CHANGE_CALCULATOR_HPP
+#define REALM_CHANGE_CALCULATOR_HPP
+
+#include "binding_context.hpp"
+#include "shared_realm.hpp"
+
+#include <realm/group_shared.hpp>
+
+#include <exception>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace realm {
+namespace _impl {
+// Calculates the changes to a Realm's observed rows on a background thread,
+// so that the thread which owns the Realm only has to advance its read
+// transaction and deliver the ready-made changes rather than also parsing the
+// transaction log.
+//
+// The calculation is done with a separate SharedGroup for the same file,
+// which begins a read transaction at the owning Realm's current version and
+// then advances it to the latest version while observing the rows.
+class ChangeCalculator {
+public:
+    using ObserverState = BindingContext::ObserverState;
+
+    struct Changes {
+        // The versions which the changes were calculated between
+        SharedGroup::VersionID from;
+        SharedGroup::VersionID to;
+        // The observers passed to request(), updated with change information
+        std::vector<ObserverState> observers;
+        // The `info` fields of observed rows which were deleted
+        std::vector<void*> invalidated;
+        // The error thrown while calculating the changes, if any
+        std::exception_ptr error;
+    };
+
+    // `on_ready` is called on the background thread each time a calculation
+    // completes
+    ChangeCalculator(Realm::Config const& config, std::function<void()> on_ready);
+    ~ChangeCalculator();
+
+    // Begin calculating the changes to the given observers from the given
+    // version to the latest version, unless that calculation is already
+    // pending or complete. Only one calculation is done at a time, so if a
+    // different one is currently running, this one starts when it completes.
+    void request(SharedGroup::VersionID from, std::vector<ObserverState> observers);
+
+    // Take the result of the most recently completed calculation if it was
+    // for the given version and observers. Returns false if there is no such
+    // result, and discards any result for a different version or observers.
+    bool take(SharedGroup::VersionID from, std::vector<ObserverState> const& observers, Changes& out);
+
+private:
+    struct State;
+    std::shared_ptr<State> m_state;
+};
+} // namespace _impl
+} // namespace realm
+
+#endif /* REALM_CHANGE_CALCULATOR_HPP */
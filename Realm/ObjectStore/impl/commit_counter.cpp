@@ -0,0 +1,283 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "commit_counter.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+using namespace realm;
+using namespace realm::_impl;
+
+// The shared data is accessed from multiple processes, which is only valid
+// for lock-free atomics
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+              "CommitCounter requires lock-free atomics");
+
+namespace {
+struct {
+    std::atomic<uint64_t> wakeups_sent;
+    std::atomic<uint64_t> wakeups_coalesced;
+    std::atomic<uint64_t> wakeups_received;
+    std::atomic<uint64_t> wakeups_delivered;
+    std::atomic<uint64_t> wakeups_skipped;
+    std::atomic<uint64_t> wakeups_uncounted;
+} s_stats;
+
+void increment(std::atomic<uint64_t>& counter)
+{
+    counter.fetch_add(1, std::memory_order_relaxed);
+}
+} // anonymous namespace
+
+CommitNotificationStats realm::_impl::get_commit_notification_stats() noexcept
+{
+    return {
+        s_stats.wakeups_sent.load(std::memory_order_relaxed),
+        s_stats.wakeups_coalesced.load(std::memory_order_relaxed),
+        s_stats.wakeups_received.load(std::memory_order_relaxed),
+        s_stats.wakeups_delivered.load(std::memory_order_relaxed),
+        s_stats.wakeups_skipped.load(std::memory_order_relaxed),
+        s_stats.wakeups_uncounted.load(std::memory_order_relaxed),
+    };
+}
+
+void realm::_impl::reset_commit_notification_stats() noexcept
+{
+    s_stats.wakeups_sent = 0;
+    s_stats.wakeups_coalesced = 0;
+    s_stats.wakeups_received = 0;
+    s_stats.wakeups_delivered = 0;
+    s_stats.wakeups_skipped = 0;
+    s_stats.wakeups_uncounted = 0;
+}
+
+CommitCounter::CommitCounter(std::string const& path)
+{
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd == -1) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    // Newly created files are empty, and extending them fills them with
+    // zeroes, which is the correct initial state. Multiple processes racing
+    // to do this is harmless since they'll all pick the same size.
+    struct stat st;
+    int ret = fstat(fd, &st);
+    if (ret == 0 && st.st_size < static_cast<off_t>(sizeof(SharedData))) {
+        ret = ftruncate(fd, sizeof(SharedData));
+    }
+    if (ret == -1) {
+        int err = errno;
+        close(fd);
+        throw std::system_error(err, std::system_category());
+    }
+
+    void* addr = mmap(nullptr, sizeof(SharedData), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int err = errno;
+    // The mapping keeps the file alive, so the fd is no longer needed
+    close(fd);
+    if (addr == MAP_FAILED) {
+        throw std::system_error(err, std::system_category());
+    }
+
+    m_data = static_cast<SharedData*>(addr);
+    m_is_shared = true;
+    m_last_seen = version();
+
+    // If the last process to have the file open exited while a wakeup was
+    // pending the flag will never be cleared, so clear it here. At worst this
+    // results in an extra wakeup.
+    m_data->wakeup_pending.store(0);
+}
+
+CommitCounter::CommitCounter()
+: m_data(new SharedData())
+, m_is_shared(false)
+, m_last_seen(0)
+{
+}
+
+CommitCounter::~CommitCounter()
+{
+    if (m_is_shared) {
+        munmap(m_data, sizeof(SharedData));
+    }
+    else {
+        delete m_data;
+    }
+}
+
+uint64_t CommitCounter::will_commit(uint64_t modified_tables, uint64_t db_version,
+                                    bool incompatible_schema_change) noexcept
+{
+    // The table versions are written before the commit is made visible so that
+    // anyone who sees the new version in commit_count also sees which tables
+    // it modified. They may also see this version for tables before the commit
+    // is visible, which just results in an unneeded wakeup.
+    uint64_t version = m_data->write_count.fetch_add(1) + 1;
+    for (size_t i = 0; i < table_slot_count; ++i) {
+        if (modified_tables & (uint64_t(1) << i)) {
+            m_data->table_versions[i].store(version);
+        }
+    }
+
+    // Similarly, anyone who can see the new database version has to be able
+    // to see whether it needs its schema changes checked. If the previous
+    // commit recorded here isn't the one this write transaction began from,
+    // the commits in between were made by a writer which doesn't record its
+    // schema changes, so any of them may have made some.
+    if (m_data->checked_db_version.load() != db_version) {
+        m_data->schema_change_version.store(db_version);
+    }
+    if (incompatible_schema_change) {
+        m_data->schema_change_version.store(db_version + 1);
+    }
+    m_data->checked_db_version.store(db_version + 1);
+    return version;
+}
+
+bool CommitCounter::commit(uint64_t version) noexcept
+{
+    // The time is written before the version is published so that anyone who
+    // sees the version will also see when it was made
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    m_data->commit_times[version % commit_time_slot_count].store(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+
+    // Commits can finish out of order with respect to the version returned
+    // from will_commit(), so only ever move the version forward
+    uint64_t current = m_data->commit_count.load();
+    while (current < version && !m_data->commit_count.compare_exchange_weak(current, version)) { }
+
+    // The counter has to be updated before checking the flag, so that a
+    // listener which clears the flag is guaranteed to then see the new count
+    if (m_data->wakeup_pending.exchange(1)) {
+        increment(s_stats.wakeups_coalesced);
+        return false;
+    }
+    increment(s_stats.wakeups_sent);
+    return true;
+}
+
+auto CommitCounter::consume() noexcept -> Wakeup
+{
+    increment(s_stats.wakeups_received);
+
+    // Clear the flag before reading the count so that any commit which
+    // doesn't see the flag set will send a new wakeup
+    bool pending = m_data->wakeup_pending.exchange(0);
+    uint64_t count = version();
+    if (count != m_last_seen) {
+        m_last_seen = count;
+        increment(s_stats.wakeups_delivered);
+        return Wakeup::Counted;
+    }
+
+    // Every writer which updates the counter sets the flag before writing
+    // to the pipe, so a wakeup which finds neither the flag set nor a new
+    // count may be from one which doesn't. It may also be a second wakeup for
+    // a commit which another listener on the file already consumed, which
+    // can't be told apart, so it's treated as a real one.
+    if (!pending) {
+        increment(s_stats.wakeups_uncounted);
+        return Wakeup::Uncounted;
+    }
+    increment(s_stats.wakeups_skipped);
+    return Wakeup::Redundant;
+}
+
+uint64_t CommitCounter::version() const noexcept
+{
+    return m_data->commit_count.load();
+}
+
+bool CommitCounter::tables_modified_since(uint64_t version, uint64_t tables) const noexcept
+{
+    for (size_t i = 0; i < table_slot_count; ++i) {
+        if ((tables & (uint64_t(1) << i)) && m_data->table_versions[i].load() > version) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::chrono::system_clock::time_point CommitCounter::commit_time_after(uint64_t version) const noexcept
+{
+    uint64_t latest = this->version();
+    if (latest <= version) {
+        return {};
+    }
+
+    // Older slots have been overwritten by more recent commits
+    uint64_t first = version + 1;
+    if (latest - first >= commit_time_slot_count) {
+        first = latest - commit_time_slot_count + 1;
+    }
+    std::chrono::nanoseconds since_epoch(m_data->commit_times[first % commit_time_slot_count].load());
+    return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(since_epoch));
+}
+
+uint64_t CommitCounter::schema_checked_through(uint64_t db_version) const noexcept
+{
+    // will_commit() stores the schema change version before the checked
+    // version, so reading them in the opposite order guarantees seeing the
+    // schema change version of every commit up to the checked version
+    uint64_t checked = m_data->checked_db_version.load();
+    if (checked <= db_version || m_data->schema_change_version.load() > db_version) {
+        return db_version;
+    }
+    return checked;
+}
+
+void CommitCounter::record_snapshot(uint64_t db_version, uint32_t index) noexcept
+{
+    // The index is written before the version so that anyone who sees the
+    // version also sees the matching index
+    auto& snapshot = m_data->snapshots[db_version % snapshot_slot_count];
+    snapshot.index.store(index);
+    snapshot.db_version.store(db_version);
+}
+
+bool CommitCounter::find_snapshot(uint64_t after, uint64_t up_to, uint64_t& db_version, uint32_t& index) const noexcept
+{
+    bool found = false;
+    for (auto& snapshot : m_data->snapshots) {
+        uint64_t version = snapshot.db_version.load();
+        if (version <= after) {
+            continue;
+        }
+        // Prefer the newest version no later than up_to, and otherwise the
+        // oldest version
+        bool better = !found || (version <= up_to ? (db_version > up_to || version > db_version)
+                                                  : (db_version > up_to && version < db_version));
+        if (!better) {
+            continue;
+        }
+        uint32_t snapshot_index = snapshot.index.load();
+        // A newer commit may have reused the slot between the two reads
+        if (snapshot.db_version.load() == version) {
+            db_version = version;
+            index = snapshot_index;
+            found = true;
+        }
+    }
+    return found;
+}
@@ -0,0 +1,200 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_COMMIT_COUNTER_HPP
+#define REALM_COMMIT_COUNTER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace realm {
+namespace _impl {
+// Process-wide counters of how commit notifications were sent and received,
+// for verifying how many wakeups are being avoided under heavy write load
+struct CommitNotificationStats {
+    // Commits which had to wake up listeners
+    uint64_t wakeups_sent;
+    // Commits which found listeners already had a wakeup pending, and so
+    // were folded into that wakeup
+    uint64_t wakeups_coalesced;
+    // Wakeups seen by the listener thread
+    uint64_t wakeups_received;
+    // Wakeups which were passed on to the Realms' schedulers
+    uint64_t wakeups_delivered;
+    // Wakeups where no commit had been made since the previous one
+    uint64_t wakeups_skipped;
+    // Wakeups from writers which don't update the counter
+    uint64_t wakeups_uncounted;
+};
+
+CommitNotificationStats get_commit_notification_stats() noexcept;
+void reset_commit_notification_stats() noexcept;
+
+// A counter of the commits made to a Realm file, stored in a small file
+// mapped into shared memory next to the Realm file so that it is shared with
+// other processes. Along with the counter is a flag which is set when a
+// wakeup is sent to listeners and cleared when a listener wakes up, so that
+// a burst of commits made before anyone has woken up results in only a single
+// wakeup, and listeners can tell a wakeup with no new commits from a real one.
+//
+// Each commit also records its version in a slot for each of the tables it
+// modified, so that listeners can tell if any of the tables they care about
+// have been modified since they last checked. Tables share slots modulo
+// `table_slot_count`, which results in some extra wakeups for files with
+// more tables than that but is otherwise harmless.
+//
+// The time at which each of the most recent commits was made is also recorded,
+// so that listeners can measure how long it took for a commit to be delivered.
+//
+// The most recent commit which made schema changes that other Realm
+// instances have to reject is recorded, along with the database version of
+// the most recent commit which was checked for them, so that readers can skip
+// checking the transaction logs for schema changes when every commit they
+// advance over is known not to have made any.
+//
+// Finally, the database version and read lock index of the snapshot produced
+// by each of the most recent commits is recorded, as core can only begin a
+// read transaction at a version other than the latest given both. Readers
+// which have fallen behind use them to advance a limited number of versions
+// at a time.
+class CommitCounter {
+public:
+    static const size_t table_slot_count = 64;
+    static const size_t commit_time_slot_count = 64;
+    static const size_t snapshot_slot_count = 256;
+    static const uint64_t all_tables = ~uint64_t(0);
+
+    // Opens or creates the counter file at the given path
+    CommitCounter(std::string const& path);
+    // Creates a counter which is only shared within the current process
+    CommitCounter();
+    ~CommitCounter();
+
+    // Record that the write transaction currently being committed modified
+    // the given tables, as a bitmask of table slots, and whether it made
+    // schema changes which other Realm instances have to reject. `db_version`
+    // is the database version which the write transaction began from. Must
+    // be called while holding the write lock, before the commit is made.
+    // Returns the version to pass to commit() once the commit has been made.
+    uint64_t will_commit(uint64_t modified_tables, uint64_t db_version,
+                         bool incompatible_schema_change) noexcept;
+
+    // Record that a commit was made. Returns true if listeners need to be
+    // woken up, or false if there is already a wakeup pending which will
+    // cover this commit.
+    bool commit(uint64_t version) noexcept;
+
+    enum class Wakeup {
+        // No commits have been made since the last wakeup, which happens when
+        // a listener wakes up for a burst of commits it has already seen
+        Redundant,
+        // There have been commits since the last wakeup, and the table slots
+        // record what they modified
+        Counted,
+        // The named pipe was written to without the counter being updated,
+        // such as by an older version of the library or another tool which
+        // doesn't know about the counter file, so any table may have changed
+        Uncounted,
+    };
+
+    // Called by the listener when it is woken up, to find out which kind of
+    // wakeup it was. Must only be called by a single thread.
+    Wakeup consume() noexcept;
+
+    // The version of the most recent commit
+    uint64_t version() const noexcept;
+
+    // Have any of the given tables been modified by a commit after the
+    // given version?
+    bool tables_modified_since(uint64_t version, uint64_t tables) const noexcept;
+
+    // Get the time at which the first commit after the given version was
+    // made, or the time of the oldest commit still recorded if more than
+    // commit_time_slot_count commits have been made since then. Returns the
+    // clock's epoch if no commits have been made since the version.
+    std::chrono::system_clock::time_point commit_time_after(uint64_t version) const noexcept;
+
+    // Get the newest database version such that every commit after
+    // `db_version` up to and including it is known not to have made schema
+    // changes which have to be rejected. Returns `db_version` itself if there
+    // is no such version, because a commit after it made such changes or was
+    // made by a writer which doesn't record whether it did, or because no
+    // commits after it have been recorded. Unlike the other versions here,
+    // these are versions of the Realm file's read transactions.
+    uint64_t schema_checked_through(uint64_t db_version) const noexcept;
+
+    // Record the snapshot produced by a commit, identified by its database
+    // version and read lock index. Must be called after committing.
+    void record_snapshot(uint64_t db_version, uint32_t index) noexcept;
+
+    // Find the newest recorded snapshot whose database version is after
+    // `after` and no later than `up_to`, or if there isn't one (because the
+    // commits which made them were too long ago to still be recorded, or
+    // were made by a writer which doesn't record snapshots), the oldest one
+    // after `after`. Sets `db_version` and `index` to the snapshot found, and
+    // returns false if there are no recorded snapshots after `after`.
+    bool find_snapshot(uint64_t after, uint64_t up_to, uint64_t& db_version, uint32_t& index) const noexcept;
+
+    // Get the bit in the table mask for the table with the given index
+    static uint64_t table_bit(size_t table_ndx) noexcept
+    {
+        return uint64_t(1) << (table_ndx % table_slot_count);
+    }
+
+private:
+    struct SharedData {
+        std::atomic<uint64_t> commit_count;
+        std::atomic<uint32_t> wakeup_pending;
+        // The version handed out to the most recent write transaction to
+        // begin committing, which may be ahead of commit_count
+        std::atomic<uint64_t> write_count;
+        std::atomic<uint64_t> table_versions[table_slot_count];
+        // Nanoseconds since the system clock's epoch at which each commit was
+        // made, indexed by version modulo commit_time_slot_count. The system
+        // clock is used as it's the only one comparable between processes.
+        std::atomic<int64_t> commit_times[commit_time_slot_count];
+        // The database version from which the logs have to be checked for
+        // schema changes: the one produced by the most recent commit with
+        // schema changes which have to be rejected, or the one before the
+        // most recent commit which found that commits had been made without
+        // calling will_commit(), whichever is later
+        std::atomic<uint64_t> schema_change_version;
+        // The database version produced by the most recent commit which
+        // called will_commit()
+        std::atomic<uint64_t> checked_db_version;
+        // The snapshots passed to record_snapshot(), indexed by database
+        // version modulo snapshot_slot_count
+        struct Snapshot {
+            std::atomic<uint64_t> db_version;
+            std::atomic<uint32_t> index;
+        } snapshots[snapshot_slot_count];
+    };
+
+    SharedData* m_data;
+    bool m_is_shared;
+    uint64_t m_last_seen;
+
+    CommitCounter(CommitCounter const&) = delete;
+    CommitCounter& operator=(CommitCounter const&) = delete;
+};
+} // namespace _impl
+} // namespace realm
+
+#endif /* REALM_COMMIT_COUNTER_HPP */
@@ -0,0 +1,106 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "external_commit_helper.hpp"
+
+#include "shared_realm.hpp"
+
+using namespace realm;
+using namespace realm::_impl;
+
+// tvOS doesn't allow named pipes, so it has its own implementation of
+// everything but will_commit() (see impl/apple/external_commit_helper_tvos.cpp)
+#if !TARGET_OS_TV
+// Inter-thread and inter-process notifications of changes are done using a
+// named pipe in the filesystem next to the Realm file. Everyone who wants to be
+// notified of commits waits for data to become available on the pipe, and anyone
+// who commits a write transaction writes data to the pipe after releasing the
+// write lock. Note that no one ever actually *reads* from the pipe: the data
+// actually written is meaningless, and trying to read from a pipe from multiple
+// processes at once is fraught with race conditions.
+
+// Each Realm has a Scheduler which is used to get the notification from the
+// background thread to the thread which owns the Realm. By default this is a
+// CFRunLoopSource added to the thread's runloop on Apple platforms (see
+// run_loop_scheduler.cpp) and an EventLoopScheduler elsewhere, but it can be
+// anything which eventually calls Realm::notify() on the right thread.
+
+// Waiting for data to be written to a pipe is done with kqueue() on Apple
+// platforms (impl/apple/fd_poller.cpp) and epoll() on Linux
+// (impl/linux/fd_poller.cpp), both in edge-triggered mode so that each write
+// is reported rather than just the pipe being readable.
+
+// Listening for external changes is done by a single background thread for all
+// Realm files opened in the process (see NotifierThread), so that opening many
+// different files doesn't result in many mostly-idle threads. When data is
+// written to a named pipe, the thread notifies the scheduler of each Realm
+// registered with the ExternalCommitHelper for that pipe, or if the Realm was
+// notified more recently than its minimum notification interval, sets a timer
+// on the listener thread to notify it once the interval has passed.
+ExternalCommitHelper::ExternalCommitHelper(Realm* realm)
+: m_commit_counter(realm->config().path + ".commit")
+, m_realms(m_commit_counter)
+{
+    m_notify_fd = open_notification_pipe(realm->config().path);
+    m_listener_token = NotifierThread::shared().add(m_notify_fd, [this] { return on_change(); }, [this] { return on_timer(); });
+    add_realm(realm);
+}
+
+ExternalCommitHelper::~ExternalCommitHelper()
+{
+    NotifierThread::shared().remove(m_listener_token, m_notify_fd);
+}
+
+auto ExternalCommitHelper::on_change() -> NotifierThread::clock::time_point
+{
+    switch (m_commit_counter.consume()) {
+        case CommitCounter::Wakeup::Redundant:
+            // Nothing new to deliver, but pending notifications may be due
+            return m_realms.notify_pending();
+        case CommitCounter::Wakeup::Counted:
+            return m_realms.notify_realms(m_commit_counter.version());
+        case CommitCounter::Wakeup::Uncounted:
+            // A writer which doesn't update the counter may have modified
+            // any table. This also covers writes to the named pipe for other
+            // files which share it in the temporary directory, which just
+            // result in the Realms finding nothing to advance to.
+            return m_realms.notify_realms(m_commit_counter.version(), true);
+    }
+    REALM_UNREACHABLE();
+}
+
+auto ExternalCommitHelper::on_timer() -> NotifierThread::clock::time_point
+{
+    return m_realms.notify_pending();
+}
+
+void ExternalCommitHelper::notify_others(uint64_t version)
+{
+    // Only write to the pipe if there isn't already a wakeup pending, so that
+    // a burst of commits wakes up each listener once rather than once per commit
+    if (m_commit_counter.commit(version)) {
+        notify_fd(m_notify_fd);
+    }
+}
+#endif
+
+uint64_t ExternalCommitHelper::will_commit(uint64_t modified_tables, uint64_t db_version,
+                                           bool incompatible_schema_change)
+{
+    return m_commit_counter.will_commit(modified_tables, db_version, incompatible_schema_change);
+}
@@ -0,0 +1,134 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_EXTERNAL_COMMIT_HELPER_HPP
+#define REALM_EXTERNAL_COMMIT_HELPER_HPP
+
+#include "commit_counter.hpp"
+#include "realm_registry.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#ifdef __APPLE__
+#include <TargetConditionals.h>
+#endif
+
+#if TARGET_OS_TV
+#include <mutex>
+#else
+#include "notifier_thread.hpp"
+#endif
+
+namespace realm {
+class Realm;
+
+namespace _impl {
+// Notifies the other Realm instances for a file of commits made to it, in
+// this process and in others. Everything other than how the notifications
+// get from the committing thread to the schedulers of the Realms which need
+// them is shared between platforms; see external_commit_helper.cpp for the
+// named pipe implementation used everywhere but tvOS, which only has the
+// in-process one in impl/apple/external_commit_helper_tvos.cpp.
+class ExternalCommitHelper : public std::enable_shared_from_this<ExternalCommitHelper> {
+public:
+    ExternalCommitHelper(Realm* realm);
+    ~ExternalCommitHelper();
+
+    // Record which tables the write transaction which is about to be committed
+    // modified, and whether it made schema changes which other Realms have to
+    // reject (see CommitCounter::will_commit()). Must be called with the
+    // write lock held. Returns the version to pass to notify_others() after
+    // committing.
+    uint64_t will_commit(uint64_t modified_tables, uint64_t db_version, bool incompatible_schema_change);
+    void notify_others(uint64_t version);
+
+    void add_realm(Realm* realm) { m_realms.add_realm(realm); }
+    void remove_realm(Realm* realm) { m_realms.remove_realm(realm); }
+
+    // Set which tables the given Realm needs to be woken up for changes to,
+    // as a bitmask of CommitCounter table slots
+    void set_observed_tables(Realm* realm, uint64_t tables) { m_realms.set_observed_tables(realm, tables); }
+
+    // The version of the most recent commit made to the file, and the time at
+    // which the first commit after the given version was made
+    uint64_t commit_version() const noexcept { return m_commit_counter.version(); }
+    std::chrono::system_clock::time_point commit_time_after(uint64_t version) const noexcept
+    {
+        return m_commit_counter.commit_time_after(version);
+    }
+
+    // The newest database version which a Realm at `db_version` can advance
+    // to without checking for schema changes which have to be rejected (see
+    // CommitCounter::schema_checked_through())
+    uint64_t schema_checked_through(uint64_t db_version) const noexcept
+    {
+        return m_commit_counter.schema_checked_through(db_version);
+    }
+
+    // Record the snapshot produced by a commit and find one to advance to (see
+    // CommitCounter::record_snapshot() and find_snapshot())
+    void record_snapshot(uint64_t db_version, uint32_t index) noexcept
+    {
+        m_commit_counter.record_snapshot(db_version, index);
+    }
+    bool find_snapshot(uint64_t after, uint64_t up_to, uint64_t& db_version, uint32_t& index) const noexcept
+    {
+        return m_commit_counter.find_snapshot(after, up_to, db_version, index);
+    }
+
+private:
+#if TARGET_OS_TV
+    using clock = std::chrono::steady_clock;
+
+    // Called when the time returned from RealmRegistry::notify_realms() has
+    // been reached
+    void on_timer();
+    void schedule_timer(clock::time_point when);
+
+    // Mutex which guards m_next_timer
+    std::mutex m_timer_mutex;
+    // The earliest time at which a timer is scheduled to call on_timer()
+    clock::time_point m_next_timer = clock::time_point::max();
+#else
+    // Called on the shared listener thread when the named pipe is written to,
+    // and when the time returned from the previous call to either has been
+    // reached. Both return the time at which on_timer() next needs to be
+    // called.
+    NotifierThread::clock::time_point on_change();
+    NotifierThread::clock::time_point on_timer();
+
+    // Read-write file descriptor for the named pipe which is waited on for
+    // changes and written to when a commit is made
+    FdHolder m_notify_fd;
+    // Token identifying this helper's registration with the listener thread
+    uintptr_t m_listener_token = 0;
+#endif
+
+    // Count of commits to the file and the tables they modified, shared with
+    // other processes via the .commit file where there's a named pipe
+    CommitCounter m_commit_counter;
+    // Currently registered realms and the schedulers for delivering
+    // notifications to them
+    RealmRegistry m_realms;
+};
+} // namespace _impl
+} // namespace realm
+
+#endif /* REALM_EXTERNAL_COMMIT_HELPER_HPP */
@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "incremental_rows.hpp"
+
+#include "row_comparator.hpp"
+#include "transaction_change_info.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+using namespace realm;
+using namespace realm::_impl;
+
+IncrementalRows::IncrementalRows(Query query, SortOrder sort)
+: m_table(query.get_table())
+, m_query(std::move(query))
+, m_sort(std::move(sort))
+{
+}
+
+void IncrementalRows::reset()
+{
+    auto table_view = m_query.find_all();
+    if (m_sort) {
+        table_view.sort(m_sort.columnIndices, m_sort.ascending);
+    }
+    m_rows.resize(table_view.size());
+    for (size_t i = 0; i < m_rows.size(); ++i) {
+        m_rows[i] = table_view.get_source_ndx(i);
+    }
+    ++m_full_updates;
+}
+
+bool IncrementalRows::has_link_columns() const
+{
+    for (size_t i = 0, count = m_table->get_column_count(); i < count; ++i) {
+        auto type = m_table->get_column_type(i);
+        if (type == type_Link || type == type_LinkList) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IncrementalRows::matches(size_t row_ndx) const
+{
+    return m_query.count(row_ndx, row_ndx + 1) != 0;
+}
+
+bool IncrementalRows::update(TransactionChangeInfo const& info)
+{
+    size_t table_ndx = m_table->get_index_in_group();
+    if (info.modified_other_than(table_ndx) && has_link_columns()) {
+        reset();
+        return true;
+    }
+
+    auto changes = info.find(table_ndx);
+    if (!changes) {
+        return false;
+    }
+    if (changes->cleared() || changes->untracked() || !RowComparator::can_compare(*m_table, m_sort)) {
+        reset();
+        return true;
+    }
+
+    // The rows which have to be checked against the query, by current index
+    auto candidates = changes->inserted_rows();
+    for (auto old_ndx : changes->modified_rows()) {
+        size_t new_ndx = changes->new_index(old_ndx);
+        if (new_ndx != TableChangeInfo::npos) {
+            candidates.push_back(new_ndx);
+        }
+    }
+    // Past a point re-running the query is cheaper than checking each row
+    if (candidates.size() > m_table->size() / 2) {
+        reset();
+        return true;
+    }
+
+    // Rows which are still in the results and whose sort values and index
+    // are unchanged stay in the same relative order. Rows which were moved
+    // to a new index have to be re-inserted, as that may change where they
+    // go among rows with equal sort values.
+    std::vector<size_t> kept, added;
+    kept.reserve(m_rows.size());
+    for (auto old_ndx : m_rows) {
+        if (changes->modified(old_ndx)) {
+            continue;
+        }
+        size_t new_ndx = changes->new_index(old_ndx);
+        if (new_ndx == old_ndx) {
+            kept.push_back(new_ndx);
+        }
+        else if (new_ndx != TableChangeInfo::npos) {
+            added.push_back(new_ndx);
+        }
+    }
+    for (auto row_ndx : candidates) {
+        if (matches(row_ndx)) {
+            added.push_back(row_ndx);
+        }
+    }
+
+    RowComparator comes_before(*m_table, m_sort);
+    std::sort(added.begin(), added.end(), comes_before);
+    if (added.size() < 16) {
+        // Binary searching for each row compares far fewer values than
+        // merging when only a few rows are being added
+        for (auto row_ndx : added) {
+            kept.insert(std::upper_bound(kept.begin(), kept.end(), row_ndx, comes_before), row_ndx);
+        }
+        m_rows = std::move(kept);
+    }
+    else {
+        m_rows.clear();
+        m_rows.reserve(kept.size() + added.size());
+        std::merge(kept.begin(), kept.end(), added.begin(), added.end(), std::back_inserter(m_rows), comes_before);
+    }
+    ++m_incremental_updates;
+    return true;
+}
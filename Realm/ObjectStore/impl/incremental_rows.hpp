@@ -0,0 +1,77 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_INCREMENTAL_ROWS_HPP
+#define REALM_INCREMENTAL_ROWS_HPP
+
+#include "results.hpp"
+
+#include <vector>
+
+namespace realm {
+namespace _impl {
+class TransactionChangeInfo;
+
+// The source row indices of the rows matching a query, in sort order, kept up
+// to date by applying the row changes from the transaction log rather than by
+// re-running the query and sort after every change to the table. Only the
+// inserted and modified rows are checked against the query, deleted rows are
+// dropped, and rows which were added or whose sort values may have changed
+// are inserted at their sorted position.
+//
+// The query is re-run from scratch for changes which can't be applied this
+// way: the table being cleared, rows being moved in ways which aren't
+// tracked, sorting on column types which can't be compared, and changes to
+// other tables when this one has link columns which the query may follow.
+//
+// Rows are placed with RowComparator, which keeps rows with equal sort values
+// in table order as core's sort does. Queries restricted to a LinkView aren't
+// supported, as the unsorted order of their results is the LinkView's.
+class IncrementalRows {
+public:
+    IncrementalRows(Query query, SortOrder sort);
+
+    // Run the query and sort from scratch
+    void reset();
+
+    // Apply the row changes in `info`, which must be those made since the
+    // rows were last updated. Returns false if the rows can't have changed.
+    bool update(TransactionChangeInfo const& info);
+
+    std::vector<size_t> const& rows() const noexcept { return m_rows; }
+
+    // How many times the rows have been updated from the transaction log and
+    // by re-running the query
+    size_t incremental_updates() const noexcept { return m_incremental_updates; }
+    size_t full_updates() const noexcept { return m_full_updates; }
+
+private:
+    TableRef m_table;
+    Query m_query;
+    SortOrder m_sort;
+    std::vector<size_t> m_rows;
+    size_t m_incremental_updates = 0;
+    size_t m_full_updates = 0;
+
+    bool has_link_columns() const;
+    bool matches(size_t row_ndx) const;
+};
+} // namespace _impl
+} // namespace realm
+
+#endif /* REALM_INCREMENTAL_ROWS_HPP */
@@ -0,0 +1,74 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "notifier_thread.hpp"
+
+#include <algorithm>
+#include <assert.h>
+#include <sys/epoll.h>
+#include <system_error>
+
+using namespace realm;
+using namespace realm::_impl;
+
+FdPoller::FdPoller()
+{
+    m_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_fd == -1) {
+        throw std::system_error(errno, std::system_category());
+    }
+}
+
+void FdPoller::add(int fd, uintptr_t token)
+{
+    // EPOLLET makes it report each change in the amount of data available
+    // rather than just returning immediately when there is any data to read
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLET;
+    event.data.u64 = token;
+    if (epoll_ctl(m_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
+        throw std::system_error(errno, std::system_category());
+    }
+}
+
+void FdPoller::remove(int fd)
+{
+    epoll_ctl(m_fd, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+void FdPoller::wait(std::chrono::steady_clock::time_point deadline, std::vector<uintptr_t>& tokens)
+{
+    int timeout = -1;
+    if (deadline != std::chrono::steady_clock::time_point::max()) {
+        // Round up so that we don't wake up just before the deadline
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - std::chrono::steady_clock::now()).count();
+        timeout = static_cast<int>(std::max<int64_t>(ns + 999999, 0) / 1000000);
+    }
+
+    epoll_event events[16];
+    int ret = epoll_wait(m_fd, events, 16, timeout);
+    if (ret == -1 && errno == EINTR) {
+        // Interrupted by a signal; the caller will just wait again
+        return;
+    }
+    assert(ret >= 0);
+
+    for (int i = 0; i < ret; ++i) {
+        tokens.push_back(static_cast<uintptr_t>(events[i].data.u64));
+    }
+}
@@ -0,0 +1,235 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifdef __APPLE__
+#include <TargetConditionals.h>
+#endif
+
+// tvOS doesn't allow named pipes, so there's nothing for a notifier thread to
+// wait on there (see impl/apple/external_commit_helper_tvos.cpp)
+#if !TARGET_OS_TV
+#include "notifier_thread.hpp"
+
+#include <algorithm>
+#include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sstream>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+using namespace realm;
+using namespace realm::_impl;
+
+void FdHolder::close()
+{
+    if (m_fd != -1) {
+        ::close(m_fd);
+    }
+    m_fd = -1;
+}
+
+int realm::_impl::open_notification_pipe(std::string const& realm_path)
+{
+    auto path = realm_path + ".note";
+
+    // Create and open the named pipe
+    int ret = mkfifo(path.c_str(), 0600);
+    if (ret == -1) {
+        int err = errno;
+        if (err == ENOTSUP) {
+            // Filesystem doesn't support named pipes, so try putting it in tmp instead
+            // Hash collisions are okay here because they just result in doing
+            // extra work, as opposed to correctness problems
+            std::ostringstream ss;
+            const char* tmpdir = getenv("TMPDIR");
+            ss << (tmpdir ? tmpdir : "/tmp/");
+            ss << "realm_" << std::hash<std::string>()(path) << ".note";
+            path = ss.str();
+            ret = mkfifo(path.c_str(), 0600);
+            err = errno;
+        }
+        // the fifo already existing isn't an error
+        if (ret == -1 && err != EEXIST) {
+            throw std::system_error(err, std::system_category());
+        }
+    }
+
+    // Make writing to the pipe return -1 when the pipe's buffer is full
+    // rather than blocking until there's space available
+    int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd == -1) {
+        throw std::system_error(errno, std::system_category());
+    }
+    return fd;
+}
+
+void realm::_impl::notify_fd(int fd)
+{
+    while (true) {
+        char c = 0;
+        ssize_t ret = write(fd, &c, 1);
+        if (ret == 1) {
+            break;
+        }
+
+        // If the pipe's buffer is full, we need to read some of the old data in
+        // it to make space. We don't just read in the code waiting for
+        // notifications so that we can notify multiple waiters with a single
+        // write.
+        assert(ret == -1 && errno == EAGAIN);
+        char buff[1024];
+        read(fd, buff, sizeof buff);
+    }
+}
+
+NotifierThread& NotifierThread::shared()
+{
+    // Intentionally leaked as the thread never exits, and so the object must
+    // outlive static destructors which may close Realms
+    static NotifierThread& thread = *new NotifierThread;
+    return thread;
+}
+
+NotifierThread::NotifierThread()
+{
+    // The thread runs the schedulers' notify(), which may invoke executors
+    // supplied by the user, so it gets the default stack size rather than the
+    // bare minimum needed by the listener itself
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    auto fn = [](void *self) -> void * {
+        static_cast<NotifierThread *>(self)->listen();
+        return nullptr;
+    };
+    int ret = pthread_create(&m_thread, &attr, fn, this);
+    pthread_attr_destroy(&attr);
+    if (ret != 0) {
+        throw std::system_error(ret, std::system_category());
+    }
+}
+
+uintptr_t NotifierThread::add(int fd, Callback on_change, Callback on_timer)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uintptr_t token = m_next_token++;
+    m_callbacks.emplace(token, Callbacks{std::move(on_change), std::move(on_timer)});
+    try {
+        m_poller.add(fd, token);
+    }
+    catch (...) {
+        m_callbacks.erase(token);
+        throw;
+    }
+    return token;
+}
+
+void NotifierThread::remove(uintptr_t token, int fd)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_poller.remove(fd);
+    m_callbacks.erase(token);
+    m_timers.erase(token);
+
+    // A callback removing its own registration (such as by closing the last
+    // Realm for the file) can't wait for itself to finish
+    if (!pthread_equal(pthread_self(), m_thread)) {
+        m_running_cv.wait(lock, [&] { return m_running != token; });
+    }
+}
+
+void NotifierThread::invoke(std::unique_lock<std::mutex>& lock, uintptr_t token, Callback Callbacks::*callback)
+{
+    auto it = m_callbacks.find(token);
+    if (it == m_callbacks.end()) {
+        // Removed after the event was read or the timer expired
+        return;
+    }
+
+    // Copied so that the callback can unregister itself while it's running
+    auto fn = it->second.*callback;
+    m_running = token;
+    lock.unlock();
+    auto next_timer = fn();
+    lock.lock();
+    m_running = 0;
+    m_running_cv.notify_all();
+
+    if (!m_callbacks.count(token)) {
+        return;
+    }
+    if (next_timer == clock::time_point::max()) {
+        m_timers.erase(token);
+    }
+    else {
+        m_timers[token] = next_timer;
+    }
+}
+
+void NotifierThread::listen()
+{
+#ifdef __APPLE__
+    pthread_setname_np("RLMRealm notification listener");
+#else
+    pthread_setname_np(pthread_self(), "Realm notifier");
+#endif
+
+    std::vector<uintptr_t> changed;
+    std::vector<uintptr_t> expired;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        // Timers are only ever set by the callbacks run on this thread, so
+        // the next deadline can't change while we're waiting
+        auto deadline = clock::time_point::max();
+        if (!m_timers.empty()) {
+            deadline = std::min_element(m_timers.begin(), m_timers.end(), [](auto const& a, auto const& b) {
+                return a.second < b.second;
+            })->second;
+        }
+        lock.unlock();
+
+        // Wait for data to become available on any of the fds or for the
+        // next timer to expire
+        changed.clear();
+        m_poller.wait(deadline, changed);
+
+        lock.lock();
+        for (auto token : changed) {
+            invoke(lock, token, &Callbacks::on_change);
+        }
+
+        // The callbacks may set new timers, so the expired ones are found
+        // before calling any of them
+        auto now = clock::now();
+        expired.clear();
+        for (auto const& timer : m_timers) {
+            if (timer.second <= now) {
+                expired.push_back(timer.first);
+            }
+        }
+        for (auto token : expired) {
+            m_timers.erase(token);
+            invoke(lock, token, &Callbacks::on_timer);
+        }
+    }
+}
+#endif
@@ -0,0 +1,142 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_NOTIFIER_THREAD_HPP
+#define REALM_NOTIFIER_THREAD_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <pthread.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace realm {
+namespace _impl {
+// A RAII holder for a file descriptor which automatically closes the wrapped
+// fd when it's deallocated
+class FdHolder {
+public:
+    FdHolder() = default;
+    ~FdHolder() { close(); }
+    operator int() const { return m_fd; }
+
+    FdHolder& operator=(int newFd) {
+        close();
+        m_fd = newFd;
+        return *this;
+    }
+
+private:
+    int m_fd = -1;
+    void close();
+
+    FdHolder& operator=(FdHolder const&) = delete;
+    FdHolder(FdHolder const&) = delete;
+};
+
+// Create the named pipe used to announce commits to the Realm file at the
+// given path (or one in the temporary directory if the filesystem doesn't
+// support named pipes), and open it for non-blocking reading and writing
+int open_notification_pipe(std::string const& realm_path);
+
+// Write a byte to a pipe to notify anyone waiting for data on the pipe
+void notify_fd(int fd);
+
+// Waits for data to be written to any of a set of file descriptors. This is
+// the only part of NotifierThread which differs between platforms: it uses
+// kqueue() on Apple platforms (impl/apple/fd_poller.cpp) and
+// epoll() on Linux (impl/linux/fd_poller.cpp).
+class FdPoller {
+public:
+    FdPoller();
+
+    // Report each write to `fd` as `token` until remove() is called. Constant
+    // time in the number of fds being listened to.
+    void add(int fd, uintptr_t token);
+    void remove(int fd);
+
+    // Wait until data is written to any of the fds or `deadline` passes, and
+    // append the tokens for the fds which were written to to `tokens`. Waits
+    // indefinitely if `deadline` is time_point::max().
+    void wait(std::chrono::steady_clock::time_point deadline, std::vector<uintptr_t>& tokens);
+
+private:
+    // File descriptor for the kqueue or epoll instance
+    FdHolder m_fd;
+};
+
+// A single background thread shared by every ExternalCommitHelper in the
+// process, which waits for changes to any of the registered named pipes and
+// invokes the callback registered for the pipe which changed. Each registered
+// fd is tagged with a unique token rather than a pointer so that events which
+// were read just before the fd was unregistered can be safely discarded.
+//
+// The callbacks are invoked without any locks held, as they wake up Realms via
+// their schedulers, which may run arbitrary code (such as opening or closing
+// Realms) before returning.
+class NotifierThread {
+public:
+    static NotifierThread& shared();
+
+    using clock = std::chrono::steady_clock;
+    // A callback returns the time at which `on_timer` should next be called,
+    // or time_point::max() if it shouldn't be
+    using Callback = std::function<clock::time_point()>;
+
+    // Register the fd and return the token to use to unregister it. `on_change`
+    // is called when data is written to the fd, and `on_timer` when the time
+    // returned from the last callback is reached.
+    uintptr_t add(int fd, Callback on_change, Callback on_timer);
+    // Unregister the fd with the given token. The callbacks are guaranteed to
+    // not be called again once this returns, and to not be running unless
+    // this was called from within one of them.
+    void remove(uintptr_t token, int fd);
+
+private:
+    struct Callbacks {
+        Callback on_change;
+        Callback on_timer;
+    };
+
+    NotifierThread();
+    void listen();
+    // Invoke one of the callbacks for the token if it's still registered
+    void invoke(std::unique_lock<std::mutex>& lock, uintptr_t token, Callback Callbacks::*callback);
+
+    FdPoller m_poller;
+    pthread_t m_thread;
+
+    // Mutex which guards m_callbacks, m_timers, m_next_token and m_running
+    std::mutex m_mutex;
+    std::unordered_map<uintptr_t, Callbacks> m_callbacks;
+    // The deadlines of all of the timers which are currently set
+    std::unordered_map<uintptr_t, clock::time_point> m_timers;
+    uintptr_t m_next_token = 1;
+    // The token whose callback is currently being invoked, if any, and the
+    // condition variable signalled when it finishes
+    uintptr_t m_running = 0;
+    std::condition_variable m_running_cv;
+};
+} // namespace _impl
+} // namespace realm
+
+#endif /* REALM_NOTIFIER_THREAD_HPP */
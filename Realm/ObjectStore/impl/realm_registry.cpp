@@ -0,0 +1,141 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "realm_registry.hpp"
+
+#include "commit_counter.hpp"
+#include "scheduler.hpp"
+#include "shared_realm.hpp"
+
+#include <algorithm>
+
+using namespace realm;
+using namespace realm::_impl;
+
+RealmRegistry::~RealmRegistry()
+{
+    REALM_ASSERT_DEBUG(m_realms.empty());
+}
+
+void RealmRegistry::add_realm(Realm* realm)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_realms.push_back({realm, realm->config().scheduler, CommitCounter::all_tables, m_commit_counter.version(),
+                        realm->config().min_notification_interval, {}, false});
+}
+
+void RealmRegistry::remove_realm(Realm* realm)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_realms.begin(); it != m_realms.end(); ++it) {
+        if (it->realm == realm) {
+            m_realms.erase(it);
+            return;
+        }
+    }
+    REALM_TERMINATE("Realm not registered");
+}
+
+void RealmRegistry::set_observed_tables(Realm* realm, uint64_t tables)
+{
+    std::shared_ptr<Scheduler> to_notify;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = std::find_if(m_realms.begin(), m_realms.end(), [&](auto const& info) { return info.realm == realm; });
+        if (it == m_realms.end()) {
+            REALM_TERMINATE("Realm not registered");
+        }
+
+        // If tables were added which have been modified since the Realm was
+        // last checked, it needs to be woken up now as the wakeup for those
+        // changes was skipped
+        if (m_commit_counter.tables_modified_since(it->last_version, tables & ~it->observed_tables)) {
+            to_notify = it->scheduler;
+        }
+        it->observed_tables = tables;
+    }
+
+    if (to_notify) {
+        to_notify->notify();
+    }
+}
+
+auto RealmRegistry::notify_realms(uint64_t version, bool all_tables) -> clock::time_point
+{
+    std::vector<std::shared_ptr<Scheduler>> to_notify;
+    clock::time_point next;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& info : m_realms) {
+            if (all_tables || info.observed_tables == CommitCounter::all_tables ||
+                m_commit_counter.tables_modified_since(info.last_version, info.observed_tables)) {
+                info.pending = true;
+            }
+            info.last_version = version;
+        }
+        next = collect_due(to_notify);
+    }
+
+    notify(to_notify);
+    return next;
+}
+
+auto RealmRegistry::notify_pending() -> clock::time_point
+{
+    std::vector<std::shared_ptr<Scheduler>> to_notify;
+    clock::time_point next;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        next = collect_due(to_notify);
+    }
+
+    notify(to_notify);
+    return next;
+}
+
+auto RealmRegistry::collect_due(std::vector<std::shared_ptr<Scheduler>>& to_notify) -> clock::time_point
+{
+    auto now = clock::now();
+    auto next = clock::time_point::max();
+    for (auto& info : m_realms) {
+        if (!info.pending) {
+            continue;
+        }
+
+        // Realms which were notified too recently are left pending until
+        // their minimum interval has passed, so that all of the commits made
+        // in the meantime are delivered as a single notification
+        auto due = info.last_notified + info.min_interval;
+        if (due > now) {
+            next = std::min(next, due);
+            continue;
+        }
+
+        info.pending = false;
+        info.last_notified = now;
+        to_notify.push_back(info.scheduler);
+    }
+    return next;
+}
+
+void RealmRegistry::notify(std::vector<std::shared_ptr<Scheduler>> const& schedulers)
+{
+    for (auto& scheduler : schedulers) {
+        scheduler->notify();
+    }
+}
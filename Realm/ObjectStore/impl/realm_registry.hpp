@@ -0,0 +1,99 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_REALM_REGISTRY_HPP
+#define REALM_REALM_REGISTRY_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace realm {
+class Realm;
+class Scheduler;
+
+namespace _impl {
+class CommitCounter;
+
+// The Realm instances registered with an ExternalCommitHelper, the tables each
+// of them observes, and the bookkeeping for deciding which of them need to be
+// woken up after a commit. This is the same for every platform; only how the
+// wakeups and timers are delivered differs.
+class RealmRegistry {
+public:
+    using clock = std::chrono::steady_clock;
+
+    RealmRegistry(CommitCounter const& commit_counter) : m_commit_counter(commit_counter) { }
+    ~RealmRegistry();
+
+    void add_realm(Realm* realm);
+    void remove_realm(Realm* realm);
+
+    // Set which tables the given Realm needs to be woken up for changes to,
+    // as a bitmask of CommitCounter table slots
+    void set_observed_tables(Realm* realm, uint64_t tables);
+
+    // Wake up each Realm which observes a table modified since it was last
+    // checked, or every Realm if `all_tables` is set because the tables which
+    // were modified aren't known. Returns the time at which notify_pending()
+    // next needs to be called, or time_point::max() if there's no
+    // notifications waiting.
+    clock::time_point notify_realms(uint64_t version, bool all_tables = false);
+    // Wake up each Realm with a pending notification whose minimum interval
+    // has passed, with the same return value as notify_realms()
+    clock::time_point notify_pending();
+
+private:
+    struct PerRealmInfo {
+        Realm* realm;
+        std::shared_ptr<Scheduler> scheduler;
+        // Tables which the Realm wants to be notified about changes to
+        uint64_t observed_tables;
+        // The commit version the last time the Realm was checked for changes
+        uint64_t last_version;
+        // The minimum time between notifications to the Realm
+        clock::duration min_interval;
+        // The last time the Realm was notified
+        clock::time_point last_notified;
+        // Is there a notification waiting for min_interval to pass?
+        bool pending;
+    };
+
+    // Mark each Realm with a pending notification whose minimum interval has
+    // passed as notified and add its scheduler to `to_notify`, returning the
+    // time at which the next one will be due. Must be called with m_mutex held.
+    clock::time_point collect_due(std::vector<std::shared_ptr<Scheduler>>& to_notify);
+
+    // Schedulers are only ever notified after releasing m_mutex, as ones which
+    // deliver synchronously may call back into the registry
+    static void notify(std::vector<std::shared_ptr<Scheduler>> const& schedulers);
+
+    CommitCounter const& m_commit_counter;
+
+    // Mutex which guards m_realms
+    std::mutex m_mutex;
+    // Currently registered realms and the schedulers for delivering
+    // notifications to them
+    std::vector<PerRealmInfo> m_realms;
+};
+} // namespace _impl
+} // namespace realm
+
+#endif /* REALM_REALM_REGISTRY_HPP */
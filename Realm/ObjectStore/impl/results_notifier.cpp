@@ -0,0 +1,258 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "results_notifier.hpp"
+
+#include "incremental_rows.hpp"
+#include "transaction_change_info.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+using namespace realm;
+using namespace realm::_impl;
+
+namespace {
+// Get the indices into `rows` of the longest subsequence whose old indices are
+// increasing. These rows can stay where they are, and every other row which
+// is in both versions has to be reported as moved.
+std::vector<size_t> longest_increasing_subsequence(std::vector<std::pair<size_t, size_t>> const& rows)
+{
+    // tails[n] is the index into rows of the smallest tail of an increasing
+    // subsequence of length n + 1 found so far
+    std::vector<size_t> tails;
+    std::vector<size_t> prev(rows.size(), npos);
+
+    for (size_t i = 0; i < rows.size(); ++i) {
+        auto it = std::lower_bound(tails.begin(), tails.end(), rows[i].first,
+                                   [&](size_t ndx, size_t old_ndx) { return rows[ndx].first < old_ndx; });
+        if (it != tails.begin()) {
+            prev[i] = *(it - 1);
+        }
+        if (it == tails.end()) {
+            tails.push_back(i);
+        }
+        else {
+            *it = i;
+        }
+    }
+
+    std::vector<size_t> ret(tails.size());
+    size_t i = tails.empty() ? npos : tails.back();
+    for (size_t j = ret.size(); j > 0; --j) {
+        ret[j - 1] = i;
+        i = prev[i];
+    }
+    return ret;
+}
+
+// Calculate the changes between the rows in a collection before and after a
+// set of changes to the rows in the table
+CollectionChangeSet calculate_changes(std::vector<size_t> const& old_rows,
+                                      std::vector<size_t> const& new_rows,
+                                      TableChangeInfo const& table)
+{
+    CollectionChangeSet changes;
+
+    // Map from the current index of each row in the old results to its
+    // position in them
+    std::unordered_map<size_t, size_t> old_positions;
+    old_positions.reserve(old_rows.size());
+    for (size_t i = 0; i < old_rows.size(); ++i) {
+        size_t new_ndx = table.new_index(old_rows[i]);
+        if (new_ndx != TableChangeInfo::npos) {
+            old_positions.emplace(new_ndx, i);
+        }
+    }
+
+    // Pairs of old and new positions for the rows which are in both, ordered
+    // by new position
+    std::vector<std::pair<size_t, size_t>> matched;
+    std::vector<bool> still_present(old_rows.size());
+    for (size_t i = 0; i < new_rows.size(); ++i) {
+        auto it = old_positions.find(new_rows[i]);
+        if (it == old_positions.end()) {
+            changes.insertions.add(i);
+            continue;
+        }
+        size_t old_ndx = it->second;
+        matched.push_back({old_ndx, i});
+        still_present[old_ndx] = true;
+        if (table.modified(old_rows[old_ndx])) {
+            changes.modifications.add(i);
+        }
+    }
+
+    for (size_t i = 0; i < old_rows.size(); ++i) {
+        if (!still_present[i]) {
+            changes.deletions.add(i);
+        }
+    }
+
+    // Rows which are still in the same relative order don't need to be moved,
+    // so only rows outside of the longest run which is in order are reported
+    auto stationary = longest_increasing_subsequence(matched);
+    size_t next_stationary = 0;
+    for (size_t i = 0; i < matched.size(); ++i) {
+        if (next_stationary < stationary.size() && stationary[next_stationary] == i) {
+            ++next_stationary;
+            continue;
+        }
+        changes.moves.push_back({matched[i].first, matched[i].second});
+        changes.deletions.add(matched[i].first);
+        changes.insertions.add(matched[i].second);
+    }
+
+    return changes;
+}
+} // anonymous namespace
+
+NotificationToken::NotificationToken(std::shared_ptr<ResultsNotifier> notifier)
+: m_notifier(std::move(notifier))
+{
+}
+
+NotificationToken::~NotificationToken()
+{
+    if (m_notifier) {
+        m_notifier->unregister();
+    }
+}
+
+NotificationToken& NotificationToken::operator=(NotificationToken&& rgt)
+{
+    if (this != &rgt) {
+        if (m_notifier) {
+            m_notifier->unregister();
+        }
+        m_notifier = std::move(rgt.m_notifier);
+    }
+    return *this;
+}
+
+ResultsNotifier::ResultsNotifier(SharedRealm realm, Query query, SortOrder sort, CollectionChangeCallback callback,
+                                 bool incremental)
+: m_realm(std::move(realm))
+, m_table(query.get_table())
+, m_query(std::move(query))
+, m_sort(std::move(sort))
+, m_callback(std::move(callback))
+{
+    if (incremental) {
+        m_incremental_rows = std::make_unique<IncrementalRows>(m_query, m_sort);
+    }
+}
+
+ResultsNotifier::~ResultsNotifier() = default;
+
+std::vector<size_t> const* ResultsNotifier::rows() const noexcept
+{
+    if (!m_has_baseline) {
+        return nullptr;
+    }
+    return m_incremental_rows ? &m_incremental_rows->rows() : &m_previous_rows;
+}
+
+std::vector<size_t> ResultsNotifier::current_rows()
+{
+    if (m_incremental_rows) {
+        return m_incremental_rows->rows();
+    }
+    std::vector<size_t> rows;
+    rows.reserve(m_table_view.size());
+    for (size_t i = 0; i < m_table_view.size(); ++i) {
+        rows.push_back(m_table_view.get_source_ndx(i));
+    }
+    return rows;
+}
+
+void ResultsNotifier::update_baseline()
+{
+    if (!m_table->is_attached()) {
+        return;
+    }
+
+    if (m_incremental_rows) {
+        m_incremental_rows->reset();
+    }
+    else if (!m_table_view.is_attached()) {
+        m_table_view = m_query.find_all();
+        if (m_sort) {
+            m_table_view.sort(m_sort.columnIndices, m_sort.ascending);
+        }
+    }
+    else {
+        m_table_view.sync_if_needed();
+    }
+    if (m_callback || !m_incremental_rows) {
+        m_previous_rows = current_rows();
+    }
+    m_has_baseline = true;
+}
+
+void ResultsNotifier::deliver(TransactionChangeInfo const& info)
+{
+    if (!m_registered) {
+        return;
+    }
+    if (!m_table->is_attached()) {
+        // The Realm was invalidated, which invalidates all Results as well
+        unregister();
+        return;
+    }
+    if (!m_has_baseline) {
+        // Registered within a write transaction, so there's nothing to compare
+        // the current rows to
+        update_baseline();
+        return;
+    }
+
+    auto table_changes = info.find(m_table->get_index_in_group());
+    if (m_incremental_rows) {
+        if (!m_incremental_rows->update(info) || !m_callback) {
+            return;
+        }
+    }
+    else {
+        if (!table_changes && m_table_view.is_in_sync()) {
+            // Neither the table nor anything the query depends on has changed
+            return;
+        }
+        m_table_view.sync_if_needed();
+    }
+
+    auto new_rows = current_rows();
+    auto changes = calculate_changes(m_previous_rows, new_rows,
+                                     table_changes ? *table_changes : TableChangeInfo());
+    m_previous_rows = std::move(new_rows);
+
+    if (!changes.empty()) {
+        m_callback(changes);
+    }
+}
+
+void ResultsNotifier::unregister() noexcept
+{
+    if (!m_registered) {
+        return;
+    }
+    m_registered = false;
+    if (auto realm = m_realm.lock()) {
+        realm->unregister_results_notifier(this);
+    }
+}
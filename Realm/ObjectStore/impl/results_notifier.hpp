@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_RESULTS_NOTIFIER_HPP
+#define REALM_RESULTS_NOTIFIER_HPP
+
+#include "collection_notifications.hpp"
+#include "results.hpp"
+
+#include <realm/table_view.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace realm {
+namespace _impl {
+class IncrementalRows;
+class TransactionChangeInfo;
+
+// Calculates the changes to a Results between each version of the Realm that
+// it sees, and passes them to a callback. Keeps its own copy of the query and
+// the rows which matched it last time, so that it's unaffected by the Results
+// it was created from being modified or destroyed.
+//
+// If `incremental` is set, the rows are kept up to date with IncrementalRows
+// rather than by re-running the query whenever the table changes. The
+// callback may be null, in which case the notifier only keeps rows() up to
+// date.
+class ResultsNotifier {
+public:
+    ResultsNotifier(SharedRealm realm, Query query, SortOrder sort, CollectionChangeCallback callback,
+                    bool incremental = false);
+    ~ResultsNotifier();
+
+    // Record the current rows in the results, which the next set of changes
+    // will be calculated relative to
+    void update_baseline();
+
+    // Rerun the query if it may have changed, and call the callback if the
+    // rows in the results were changed. `info` must hold the row changes made
+    // between the version the baseline was recorded at and the current one.
+    void deliver(TransactionChangeInfo const& info);
+
+    // Stop delivering notifications and remove this notifier from its Realm
+    void unregister() noexcept;
+    bool is_registered() const noexcept { return m_registered; }
+
+    // The source row indices of the results as of the last time the
+    // notifier was updated, or null if it hasn't been yet
+    std::vector<size_t> const* rows() const noexcept;
+
+private:
+    WeakRealm m_realm;
+    TableRef m_table;
+    Query m_query;
+    SortOrder m_sort;
+    TableView m_table_view;
+    std::unique_ptr<IncrementalRows> m_incremental_rows;
+    CollectionChangeCallback m_callback;
+
+    // The source row indices of the results as of the baseline
+    std::vector<size_t> m_previous_rows;
+    bool m_has_baseline = false;
+    bool m_registered = true;
+
+    std::vector<size_t> current_rows();
+};
+} // namespace _impl
+} // namespace realm
+
+#endif /* REALM_RESULTS_NOTIFIER_HPP */
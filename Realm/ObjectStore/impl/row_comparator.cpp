@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "row_comparator.hpp"
+
+#include <realm/unicode.hpp>
+
+using namespace realm;
+using namespace realm::_impl;
+
+namespace {
+template<typename T>
+int compare(T const& a, T const& b)
+{
+    return a < b ? -1 : b < a ? 1 : 0;
+}
+
+// Compare the values in a column of two rows the way core does when sorting:
+// nulls before everything else, and strings in core's collation order
+int compare_values(Table const& table, size_t col, size_t a, size_t b)
+{
+    if (table.is_nullable(col)) {
+        bool a_null = table.is_null(col, a), b_null = table.is_null(col, b);
+        if (a_null || b_null) {
+            return a_null == b_null ? 0 : a_null ? -1 : 1;
+        }
+    }
+
+    switch (table.get_column_type(col)) {
+        case type_Int:
+            return compare(table.get_int(col, a), table.get_int(col, b));
+        case type_Bool:
+            return compare(table.get_bool(col, a), table.get_bool(col, b));
+        case type_Float:
+            return compare(table.get_float(col, a), table.get_float(col, b));
+        case type_Double:
+            return compare(table.get_double(col, a), table.get_double(col, b));
+        case type_DateTime:
+            return compare(table.get_datetime(col, a).get_datetime(), table.get_datetime(col, b).get_datetime());
+        case type_String: {
+            StringData a_value = table.get_string(col, a), b_value = table.get_string(col, b);
+            if (a_value == b_value) {
+                return 0;
+            }
+            return utf8_compare(a_value, b_value) ? -1 : 1;
+        }
+        default:
+            REALM_UNREACHABLE();
+    }
+}
+} // anonymous namespace
+
+bool RowComparator::can_compare(Table const& table, SortOrder const& sort)
+{
+    for (auto col : sort.columnIndices) {
+        switch (table.get_column_type(col)) {
+            case type_Int:
+            case type_Bool:
+            case type_Float:
+            case type_Double:
+            case type_DateTime:
+            case type_String:
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+bool RowComparator::operator()(size_t a, size_t b) const
+{
+    for (size_t i = 0; i < m_sort->columnIndices.size(); ++i) {
+        int cmp = compare_values(*m_table, m_sort->columnIndices[i], a, b);
+        if (cmp != 0) {
+            return m_sort->ascending[i] ? cmp < 0 : cmp > 0;
+        }
+    }
+    return a < b;
+}
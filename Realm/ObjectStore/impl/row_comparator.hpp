@@ -0,0 +1,48 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_ROW_COMPARATOR_HPP
+#define REALM_ROW_COMPARATOR_HPP
+
+#include "results.hpp"
+
+namespace realm {
+namespace _impl {
+// Orders the rows of a table the way core's stable sort of a query's results
+// orders them for a sort order: nulls before everything else, strings in
+// core's collation order, and rows with equal sort values in table order.
+// Used to place rows without having core sort every matching row.
+class RowComparator {
+public:
+    RowComparator(Table const& table, SortOrder const& sort) : m_table(&table), m_sort(&sort) { }
+
+    // Can all of the sort order's columns be compared? Core can sort some
+    // column types which this can't.
+    static bool can_compare(Table const& table, SortOrder const& sort);
+
+    // Does the row at `a` come before the row at `b`?
+    bool operator()(size_t a, size_t b) const;
+
+private:
+    Table const* m_table;
+    SortOrder const* m_sort;
+};
+} // namespace _impl
+} // namespace realm
+
+#endif /* REALM_ROW_COMPARATOR_HPP */
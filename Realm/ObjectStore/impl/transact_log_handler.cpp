@@ -19,14 +19,31 @@
 #include "transact_log_handler.hpp"
 
 #include "binding_context.hpp"
+#include "commit_counter.hpp"
+#include "commit_stats.hpp"
+#include "transaction_change_info.hpp"
 
 #include <realm/commit_log.hpp>
 #include <realm/group_shared.hpp>
+#include <realm/impl/input_stream.hpp>
+#include <realm/impl/transact_log.hpp>
 #include <realm/lang_bind_helper.hpp>
 
+#include <unordered_map>
+
 using namespace realm;
 
 namespace {
+// The error thrown when a transaction log contains schema changes which aren't
+// supported while a Realm is open
+class SchemaMismatchError : public std::runtime_error {
+public:
+    SchemaMismatchError()
+    : std::runtime_error("Schema mismatch detected: another process has modified the Realm file's schema in an incompatible way")
+    {
+    }
+};
+
 // A transaction log handler that just validates that all operations made are
 // ones supported by the object store
 class TransactLogValidator {
@@ -41,7 +58,7 @@ class TransactLogValidator {
     REALM_NOINLINE
     void schema_error()
     {
-        throw std::runtime_error("Schema mismatch detected: another process has modified the Realm file's schema in an incompatible way");
+        throw SchemaMismatchError();
     }
 
     // Throw an exception if the currently modified table already existed before
@@ -143,12 +160,33 @@ class TransactLogObserver : public TransactLogValidator {
     using ColumnInfo = BindingContext::ColumnInfo;
     using ObserverState = BindingContext::ObserverState;
 
+    // The range in m_observers of the observers for a single row. The
+    // observers are initially sorted, so all of the observers for a row are
+    // adjacent, and they are only ever moved as a group.
+    struct ObserverRange {
+        size_t begin;
+        size_t end;
+    };
+    using RowIndex = std::unordered_map<size_t, ObserverRange>;
+
     // Observed table rows which need change information
     std::vector<ObserverState> m_observers;
+    // The observers for each table, keyed by their current row index, so that
+    // each row operation only has to look at the observers it affects
+    std::vector<RowIndex> m_observer_index;
+    // Number of observers in m_observers which have been invalidated but not
+    // yet removed
+    size_t m_invalidated_count = 0;
     // Userdata pointers for rows which have been deleted
     std::vector<void *> invalidated;
     // Delegate to send change information to
     BindingContext* m_context;
+    // Did the delegate ask for change information for any rows?
+    bool m_observing = false;
+    // Row changes for each table, for observers of query results
+    _impl::TransactionChangeInfo* m_info;
+    // Time spent in the delegate's callbacks is added to this if it's set
+    _impl::transaction::AdvanceTimings* m_timings;
 
     // Change information for the currently selected LinkList, if any
     ColumnInfo* m_active_linklist = nullptr;
@@ -181,27 +219,99 @@ class TransactLogObserver : public TransactLogValidator {
     // Mark the given row/col as needing notifications sent
     bool mark_dirty(size_t row_ndx, size_t col_ndx)
     {
-        auto it = lower_bound(begin(m_observers), end(m_observers), ObserverState{current_table(), row_ndx, nullptr});
-        if (it != end(m_observers) && it->table_ndx == current_table() && it->row_ndx == row_ndx) {
-            get_change(*it, col_ndx).changed = true;
+        if (m_info) {
+            m_info->get(current_table()).modify(row_ndx, col_ndx);
+        }
+        if (auto range = find_observers(row_ndx)) {
+            get_change(m_observers[range->begin], col_ndx).changed = true;
         }
         return true;
     }
 
-    // Remove the given observer from the list of observed objects and add it
-    // to the listed of invalidated objects
-    void invalidate(ObserverState *o)
+    RowIndex* observers_for_current_table()
+    {
+        return current_table() < m_observer_index.size() ? &m_observer_index[current_table()] : nullptr;
+    }
+
+    ObserverRange* find_observers(size_t row_ndx)
     {
-        invalidated.push_back(o->info);
-        m_observers.erase(m_observers.begin() + (o - &m_observers[0]));
+        auto rows = observers_for_current_table();
+        if (!rows) {
+            return nullptr;
+        }
+        auto it = rows->find(row_ndx);
+        return it == rows->end() ? nullptr : &it->second;
+    }
+
+    // Build the index of observers by table and row
+    void build_observer_index()
+    {
+        m_observer_index.clear();
+        for (size_t i = 0; i < m_observers.size(); ++i) {
+            auto const& o = m_observers[i];
+            if (m_observer_index.size() <= o.table_ndx) {
+                m_observer_index.resize(o.table_ndx + 1);
+            }
+            auto& range = m_observer_index[o.table_ndx].emplace(o.row_ndx, ObserverRange{i, i}).first->second;
+            range.end = i + 1;
+        }
+    }
+
+    // Remove the invalidated observers from m_observers, which has to be done
+    // before passing it to the delegate. Invalidated observers are left in
+    // place while parsing so that removing them doesn't have to shift every
+    // observer after them each time.
+    void remove_invalidated()
+    {
+        if (m_invalidated_count == 0) {
+            return;
+        }
+        m_observers.erase(std::remove_if(m_observers.begin(), m_observers.end(),
+                                         [](auto const& o) { return o.table_ndx == npos; }),
+                          m_observers.end());
+        m_invalidated_count = 0;
+        build_observer_index();
+    }
+
+    void did_change()
+    {
+        auto start = std::chrono::steady_clock::now();
+        m_context->did_change(m_observers, invalidated);
+        if (m_timings) {
+            m_timings->callbacks += std::chrono::steady_clock::now() - start;
+        }
+    }
+
+    // Mark the observers in the given range as no longer observing anything
+    // and add them to the list of invalidated objects
+    void invalidate(ObserverRange range)
+    {
+        for (size_t i = range.begin; i < range.end; ++i) {
+            invalidated.push_back(m_observers[i].info);
+            m_observers[i].table_ndx = npos;
+        }
+        m_invalidated_count += range.end - range.begin;
+    }
+
+    // Set the row index of all of the observers in the given range
+    void set_row(ObserverRange range, size_t row_ndx)
+    {
+        for (size_t i = range.begin; i < range.end; ++i) {
+            m_observers[i].row_ndx = row_ndx;
+        }
     }
 
 public:
     template<typename Func>
-    TransactLogObserver(BindingContext* context, SharedGroup& sg, Func&& func, bool validate_schema_changes)
+    TransactLogObserver(BindingContext* context, SharedGroup& sg, Func&& func, bool validate_schema_changes,
+                        _impl::TransactionChangeInfo* info = nullptr,
+                        _impl::transaction::AdvanceTimings* timings = nullptr,
+                        bool notify_if_unchanged = true)
     : m_context(context)
+    , m_info(info)
+    , m_timings(timings)
     {
-        if (!context) {
+        if (!context && !info) {
             if (validate_schema_changes) {
                 // The handler functions are non-virtual, so the parent class's
                 // versions are called if we don't need to track changes to observed
@@ -214,8 +324,12 @@ public:
             return;
         }
 
-        m_observers = context->get_observed_rows();
-        if (m_observers.empty()) {
+        if (context) {
+            m_observers = context->get_observed_rows();
+            m_observing = !m_observers.empty();
+            build_observer_index();
+        }
+        if (!m_observing && !info) {
             auto old_version = sg.get_version_of_current_transaction();
             if (validate_schema_changes) {
                 func(static_cast<TransactLogValidator&>(*this));
@@ -224,80 +338,171 @@ public:
                 func();
             }
             if (old_version != sg.get_version_of_current_transaction()) {
-                context->did_change({}, {});
+                did_change();
             }
             return;
         }
 
+        // Row changes are needed for query observers, so the full transaction
+        // log has to be parsed even if no rows are observed
+        auto old_version = sg.get_version_of_current_transaction();
         func(*this);
-        context->did_change(m_observers, invalidated);
+        remove_invalidated();
+        bool changed = old_version != sg.get_version_of_current_transaction();
+        if (context && (changed || (m_observing && notify_if_unchanged))) {
+            did_change();
+        }
     }
 
     // Called at the end of the transaction log immediately before the version
     // is advanced
     void parse_complete()
     {
-        m_context->will_change(m_observers, invalidated);
+        remove_invalidated();
+        if (m_observing) {
+            auto start = std::chrono::steady_clock::now();
+            m_context->will_change(m_observers, invalidated);
+            if (m_timings) {
+                m_timings->callbacks += std::chrono::steady_clock::now() - start;
+            }
+        }
     }
 
     bool insert_group_level_table(size_t table_ndx, size_t prior_size, StringData name)
     {
         for (auto& observer : m_observers) {
-            if (observer.table_ndx >= table_ndx)
+            if (observer.table_ndx >= table_ndx && observer.table_ndx != npos)
                 ++observer.table_ndx;
         }
+        if (table_ndx < m_observer_index.size()) {
+            m_observer_index.insert(m_observer_index.begin() + table_ndx, RowIndex());
+        }
+        if (m_info) {
+            m_info->insert_table(table_ndx);
+        }
         TransactLogValidator::insert_group_level_table(table_ndx, prior_size, name);
         return true;
     }
 
-    bool insert_empty_rows(size_t, size_t, size_t, bool)
+    bool insert_empty_rows(size_t row_ndx, size_t num_rows, size_t prior_size, bool)
     {
-        // rows are only inserted at the end, so no need to do anything
+        // rows are only inserted at the end, so no need to update observers
+        if (m_info) {
+            m_info->get(current_table()).insert_rows(row_ndx, num_rows, prior_size);
+        }
         return true;
     }
 
-    bool erase_rows(size_t row_ndx, size_t, size_t last_row_ndx, bool unordered)
+    bool erase_rows(size_t row_ndx, size_t num_rows, size_t last_row_ndx, bool unordered)
     {
-        for (size_t i = 0; i < m_observers.size(); ++i) {
-            auto& o = m_observers[i];
-            if (o.table_ndx == current_table()) {
-                if (o.row_ndx == row_ndx) {
-                    invalidate(&o);
-                    --i;
-                }
-                else if (unordered && o.row_ndx == last_row_ndx) {
-                    o.row_ndx = row_ndx;
-                }
-                else if (!unordered && o.row_ndx > row_ndx) {
-                    o.row_ndx -= 1;
+        if (m_info) {
+            auto& table = m_info->get(current_table());
+            if (unordered) {
+                table.move_last_over(row_ndx, last_row_ndx);
+            }
+            else {
+                table.mark_untracked();
+            }
+        }
+
+        auto rows = observers_for_current_table();
+        if (!rows || rows->empty()) {
+            return true;
+        }
+
+        if (unordered) {
+            // The last row is moved over the erased one, so only those two
+            // rows' observers need to be updated
+            auto it = rows->find(row_ndx);
+            if (it != rows->end()) {
+                invalidate(it->second);
+                rows->erase(it);
+            }
+            if (row_ndx != last_row_ndx) {
+                it = rows->find(last_row_ndx);
+                if (it != rows->end()) {
+                    auto range = it->second;
+                    rows->erase(it);
+                    set_row(range, row_ndx);
+                    rows->emplace(row_ndx, range);
                 }
             }
+            return true;
+        }
+
+        // Every row after the erased ones is shifted down, so rebuild this
+        // table's index in a single pass over its observers
+        RowIndex shifted;
+        shifted.reserve(rows->size());
+        for (auto& row : *rows) {
+            if (row.first < row_ndx) {
+                shifted.emplace(row.first, row.second);
+            }
+            else if (row.first < row_ndx + num_rows) {
+                invalidate(row.second);
+            }
+            else {
+                set_row(row.second, row.first - num_rows);
+                shifted.emplace(row.first - num_rows, row.second);
+            }
+        }
+        *rows = std::move(shifted);
+        return true;
+    }
+
+    bool swap_rows(size_t row_ndx_1, size_t row_ndx_2)
+    {
+        if (m_info) {
+            m_info->get(current_table()).swap_rows(row_ndx_1, row_ndx_2);
+        }
+
+        auto rows = observers_for_current_table();
+        if (!rows || row_ndx_1 == row_ndx_2) {
+            return true;
+        }
+        auto it_1 = rows->find(row_ndx_1), it_2 = rows->find(row_ndx_2);
+        util::Optional<ObserverRange> range_1, range_2;
+        if (it_1 != rows->end()) {
+            range_1 = it_1->second;
+            rows->erase(it_1);
+        }
+        if (it_2 != rows->end()) {
+            range_2 = it_2->second;
+            rows->erase(it_2);
+        }
+        if (range_1) {
+            set_row(*range_1, row_ndx_2);
+            rows->emplace(row_ndx_2, *range_1);
+        }
+        if (range_2) {
+            set_row(*range_2, row_ndx_1);
+            rows->emplace(row_ndx_1, *range_2);
         }
         return true;
     }
 
     bool clear_table()
     {
-        for (size_t i = 0; i < m_observers.size(); ) {
-            auto& o = m_observers[i];
-            if (o.table_ndx == current_table()) {
-                invalidate(&o);
-            }
-            else {
-                ++i;
+        if (m_info) {
+            m_info->get(current_table()).clear();
+        }
+        if (auto rows = observers_for_current_table()) {
+            for (auto& row : *rows) {
+                invalidate(row.second);
             }
+            rows->clear();
         }
         return true;
     }
 
     bool select_link_list(size_t col, size_t row, size_t)
     {
+        if (m_info) {
+            m_info->get(current_table()).modify(row, col);
+        }
         m_active_linklist = nullptr;
-        for (auto& o : m_observers) {
-            if (o.table_ndx == current_table() && o.row_ndx == row) {
-                m_active_linklist = &get_change(o, col);
-                break;
-            }
+        if (auto range = find_observers(row)) {
+            m_active_linklist = &get_change(m_observers[range->begin], col);
         }
         return true;
     }
@@ -372,9 +577,9 @@ public:
         }
 
         if (o->kind == ColumnInfo::Kind::Remove)
-            old_size += o->indices.size();
+            old_size += o->indices.count();
         else if (o->kind == ColumnInfo::Kind::Insert)
-            old_size -= o->indices.size();
+            old_size -= o->indices.count();
 
         o->indices.set(old_size);
 
@@ -398,8 +603,7 @@ public:
             o->changed = true;
         }
         if (o->kind == ColumnInfo::Kind::Set) {
-            for (size_t i = from; i <= to; ++i)
-                o->indices.add(i);
+            o->indices.add_range(from, to + 1);
         }
         else {
             o->indices.set(0);
@@ -426,24 +630,287 @@ public:
     bool set_int_unique(size_t col, size_t row, int_fast64_t) { return mark_dirty(row, col); }
     bool set_string_unique(size_t col, size_t row, StringData) { return mark_dirty(row, col); }
 };
+
+// A transaction log handler which builds a bitmask of the tables which were
+// modified by a transaction, for telling other Realm instances which tables
+// they need to check for changes. Any schema change sets all of the bits, as
+// table indices may have been shifted and schema changes are rare.
+//
+// Schema changes are also run through TransactLogValidator to find out if
+// other Realm instances will have to reject them, so that they only need to
+// validate the transaction logs of commits which did so.
+//
+// As it sees every instruction anyway, it also gathers the CommitStats for the
+// commit if requested.
+class TransactLogTableTracker {
+    size_t m_current_table = 0;
+    uint64_t m_modified = 0;
+    // Row changes for each table, if requested
+    _impl::TransactionChangeInfo* m_info;
+    // Statistics about the commit, if requested
+    CommitStats* m_stats;
+
+    TransactLogValidator m_validator;
+    bool m_incompatible_schema_change = false;
+
+    bool mark_table()
+    {
+        m_modified |= _impl::CommitCounter::table_bit(m_current_table);
+        return true;
+    }
+
+    bool mark_row(size_t row_ndx)
+    {
+        if (m_info) {
+            m_info->get(m_current_table).modify(row_ndx);
+        }
+        return mark_table();
+    }
+
+    // Only called for schema changes
+    bool mark_all()
+    {
+        if (m_stats) {
+            ++m_stats->schema_changes;
+        }
+        m_modified = _impl::CommitCounter::all_tables;
+        return true;
+    }
+
+    // Get the stats for the current table, or nullptr if they aren't needed
+    CommitStats::TableStats* table_stats()
+    {
+        if (!m_stats) {
+            return nullptr;
+        }
+        if (m_stats->tables.size() <= m_current_table) {
+            m_stats->tables.resize(m_current_table + 1);
+        }
+        return &m_stats->tables[m_current_table];
+    }
+
+    bool mark_set(size_t row_ndx, size_t string_bytes = 0, size_t binary_bytes = 0)
+    {
+        if (auto stats = table_stats()) {
+            ++stats->values_set;
+            stats->string_bytes += string_bytes;
+            stats->binary_bytes += binary_bytes;
+        }
+        return mark_row(row_ndx);
+    }
+
+    bool mark_link_list()
+    {
+        if (auto stats = table_stats()) {
+            ++stats->link_list_operations;
+        }
+        return mark_table();
+    }
+
+    bool mark_incompatible()
+    {
+        m_incompatible_schema_change = true;
+        return mark_all();
+    }
+
+    // Mark all tables as modified, and check if the validator rejects the
+    // schema change made by `func`
+    template<typename Func>
+    bool mark_schema_change(Func&& func)
+    {
+        try {
+            func(m_validator);
+        }
+        catch (SchemaMismatchError const&) {
+            m_incompatible_schema_change = true;
+        }
+        return mark_all();
+    }
+
+public:
+    TransactLogTableTracker(_impl::TransactionChangeInfo* info, CommitStats* stats)
+    : m_info(info), m_stats(stats) { }
+
+    uint64_t modified_tables() const noexcept { return m_modified; }
+    bool has_incompatible_schema_change() const noexcept { return m_incompatible_schema_change; }
+
+    bool select_descriptor(int, const size_t*) { return true; }
+    bool select_table(size_t group_level_ndx, int levels, const size_t* path) noexcept
+    {
+        m_validator.select_table(group_level_ndx, levels, path);
+        m_current_table = group_level_ndx;
+        return true;
+    }
+    bool select_link_list(size_t, size_t row, size_t) { return mark_row(row); }
+
+    // Schema changes
+    bool add_search_index(size_t) { return mark_all(); }
+    bool remove_search_index(size_t) { return mark_all(); }
+    bool insert_group_level_table(size_t table_ndx, size_t prior_size, StringData name)
+    {
+        m_validator.insert_group_level_table(table_ndx, prior_size, name);
+        if (m_info) {
+            m_info->insert_table(table_ndx);
+        }
+        if (m_stats && table_ndx < m_stats->tables.size()) {
+            m_stats->tables.insert(m_stats->tables.begin() + table_ndx, CommitStats::TableStats());
+        }
+        return mark_all();
+    }
+    bool insert_column(size_t col, DataType type, StringData name, bool nullable)
+    {
+        return mark_schema_change([&](auto& v) { v.insert_column(col, type, name, nullable); });
+    }
+    bool insert_link_column(size_t col, DataType type, StringData name, size_t target, size_t backlink)
+    {
+        return mark_schema_change([&](auto& v) { v.insert_link_column(col, type, name, target, backlink); });
+    }
+    bool add_primary_key(size_t col) { return mark_schema_change([&](auto& v) { v.add_primary_key(col); }); }
+    bool set_link_type(size_t col, LinkType type) { return mark_schema_change([&](auto& v) { v.set_link_type(col, type); }); }
+
+    // Removing or renaming things is always rejected
+    bool erase_group_level_table(size_t, size_t) { return mark_incompatible(); }
+    bool rename_group_level_table(size_t, StringData) { return mark_incompatible(); }
+    bool erase_column(size_t) { return mark_incompatible(); }
+    bool erase_link_column(size_t, size_t, size_t) { return mark_incompatible(); }
+    bool rename_column(size_t, StringData) { return mark_incompatible(); }
+    bool remove_primary_key() { return mark_incompatible(); }
+    bool move_column(size_t, size_t) { return mark_incompatible(); }
+    bool move_group_level_table(size_t, size_t) { return mark_incompatible(); }
+
+    // Changes to the data in the currently selected table
+    void parse_complete() { }
+    bool insert_empty_rows(size_t row_ndx, size_t num_rows, size_t prior_size, bool)
+    {
+        if (m_info) {
+            m_info->get(m_current_table).insert_rows(row_ndx, num_rows, prior_size);
+        }
+        if (auto stats = table_stats()) {
+            stats->rows_inserted += num_rows;
+        }
+        return mark_table();
+    }
+    bool erase_rows(size_t row_ndx, size_t num_rows, size_t last_row_ndx, bool unordered)
+    {
+        if (auto stats = table_stats()) {
+            stats->rows_erased += num_rows;
+        }
+        if (m_info) {
+            auto& table = m_info->get(m_current_table);
+            if (unordered) {
+                table.move_last_over(row_ndx, last_row_ndx);
+            }
+            else {
+                table.mark_untracked();
+            }
+        }
+        return mark_table();
+    }
+    bool swap_rows(size_t row_ndx_1, size_t row_ndx_2)
+    {
+        if (m_info) {
+            m_info->get(m_current_table).swap_rows(row_ndx_1, row_ndx_2);
+        }
+        return mark_table();
+    }
+    bool clear_table()
+    {
+        if (m_info) {
+            m_info->get(m_current_table).clear();
+        }
+        if (auto stats = table_stats()) {
+            stats->cleared = true;
+        }
+        return mark_table();
+    }
+    bool link_list_set(size_t, size_t) { return mark_link_list(); }
+    bool link_list_insert(size_t, size_t) { return mark_link_list(); }
+    bool link_list_erase(size_t) { return mark_link_list(); }
+    bool link_list_nullify(size_t) { return mark_link_list(); }
+    bool link_list_clear(size_t) { return mark_link_list(); }
+    bool link_list_move(size_t, size_t) { return mark_link_list(); }
+    bool link_list_swap(size_t, size_t) { return mark_link_list(); }
+    bool set_int(size_t, size_t row, int_fast64_t) { return mark_set(row); }
+    bool set_bool(size_t, size_t row, bool) { return mark_set(row); }
+    bool set_float(size_t, size_t row, float) { return mark_set(row); }
+    bool set_double(size_t, size_t row, double) { return mark_set(row); }
+    bool set_string(size_t, size_t row, StringData value) { return mark_set(row, value.size()); }
+    bool set_binary(size_t, size_t row, BinaryData value) { return mark_set(row, 0, value.size()); }
+    bool set_date_time(size_t, size_t row, DateTime) { return mark_set(row); }
+    bool set_table(size_t, size_t row) { return mark_set(row); }
+    bool set_mixed(size_t, size_t row, const Mixed&) { return mark_set(row); }
+    bool set_link(size_t, size_t row, size_t, size_t) { return mark_set(row); }
+    bool set_null(size_t, size_t row) { return mark_set(row); }
+    bool nullify_link(size_t, size_t row, size_t) { return mark_set(row); }
+    bool insert_substring(size_t, size_t row, size_t, StringData value) { return mark_set(row, value.size()); }
+    bool erase_substring(size_t, size_t row, size_t, size_t) { return mark_set(row); }
+    bool optimize_table() { return mark_table(); }
+    bool set_int_unique(size_t, size_t row, int_fast64_t) { return mark_set(row); }
+    bool set_string_unique(size_t, size_t row, StringData value) { return mark_set(row, value.size()); }
+};
 } // anonymous namespace
 
 namespace realm {
 namespace _impl {
 namespace transaction {
-void advance(SharedGroup& sg, ClientHistory& history, BindingContext* context)
+void advance(SharedGroup& sg, ClientHistory& history, BindingContext* context,
+             TransactionChangeInfo* info, AdvanceTimings* timings, bool validate_schema_changes,
+             SharedGroup::VersionID version)
 {
+    auto start = std::chrono::steady_clock::now();
+    if (timings) {
+        timings->callbacks = {};
+    }
     TransactLogObserver(context, sg, [&](auto&&... args) {
-        LangBindHelper::advance_read(sg, history, std::move(args)...);
-    }, true);
+        LangBindHelper::advance_read(sg, history, std::move(args)..., version);
+    }, validate_schema_changes, info, timings);
+    if (timings) {
+        timings->advance = std::chrono::steady_clock::now() - start - timings->callbacks;
+    }
+}
+
+void advance(SharedGroup& sg, ClientHistory& history, BindingContext* context,
+             SharedGroup::VersionID version,
+             std::vector<BindingContext::ObserverState> const& observers,
+             std::vector<void*> const& invalidated,
+             AdvanceTimings* timings)
+{
+    using clock = std::chrono::steady_clock;
+    clock::duration callbacks{0};
+
+    auto start = clock::now();
+    if (context) {
+        context->will_change(observers, invalidated);
+    }
+    auto advance_start = clock::now();
+    callbacks += advance_start - start;
+    LangBindHelper::advance_read(sg, history, version);
+    auto advance_end = clock::now();
+    if (context) {
+        context->did_change(observers, invalidated);
+    }
+    callbacks += clock::now() - advance_end;
+
+    if (timings) {
+        timings->advance = advance_end - advance_start;
+        timings->callbacks = callbacks;
+    }
+}
+
+void advance(SharedGroup& sg, ClientHistory& history, TransactionChangeInfo& info,
+             SharedGroup::VersionID version)
+{
+    TransactLogObserver(nullptr, sg, [&](auto&&... args) {
+        LangBindHelper::advance_read(sg, history, std::move(args)..., version);
+    }, true, &info);
 }
 
 void begin(SharedGroup& sg, ClientHistory& history, BindingContext* context,
-           bool validate_schema_changes)
+           bool validate_schema_changes, TransactionChangeInfo* info, bool notify_if_unchanged)
 {
     TransactLogObserver(context, sg, [&](auto&&... args) {
         LangBindHelper::promote_to_write(sg, history, std::move(args)...);
-    }, validate_schema_changes);
+    }, validate_schema_changes, info, nullptr, notify_if_unchanged);
 }
 
 void commit(SharedGroup& sg, ClientHistory&, BindingContext* context)
@@ -455,6 +922,22 @@ void commit(SharedGroup& sg, ClientHistory&, BindingContext* context)
     }
 }
 
+uint64_t get_modified_tables(ClientHistory& history, TransactionChangeInfo* info,
+                             bool* incompatible_schema_change, CommitStats* stats)
+{
+    auto changes = history.get_uncommitted_changes();
+    if (stats) {
+        stats->transaction_log_size = changes.size();
+    }
+    TransactLogTableTracker tracker(info, stats);
+    _impl::SimpleNoCopyInputStream in(changes.data(), changes.size());
+    _impl::TransactLogParser().parse(in, tracker);
+    if (incompatible_schema_change) {
+        *incompatible_schema_change = tracker.has_incompatible_schema_change();
+    }
+    return tracker.modified_tables();
+}
+
 void cancel(SharedGroup& sg, ClientHistory& history, BindingContext* context)
 {
     TransactLogObserver(context, sg, [&](auto&&... args) {
@@ -19,26 +19,80 @@
 #ifndef REALM_TRANSACT_LOG_HANDLER_HPP
 #define REALM_TRANSACT_LOG_HANDLER_HPP
 
+#include "binding_context.hpp"
+
+#include <realm/group_shared.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
 namespace realm {
-class BindingContext;
-class SharedGroup;
 class ClientHistory;
+struct CommitStats;
 
 namespace _impl {
+class TransactionChangeInfo;
+
 namespace transaction {
+// How long advancing the read transaction took, split between the time spent
+// in the binding context's change callbacks and everything else
+struct AdvanceTimings {
+    std::chrono::steady_clock::duration advance{0};
+    std::chrono::steady_clock::duration callbacks{0};
+};
+
 // Advance the read transaction version, with change notifications sent to delegate
 // Must not be called from within a write transaction.
-void advance(SharedGroup& sg, ClientHistory& history, BindingContext* delegate);
+// If `info` is non-null, the row changes made to each table are added to it.
+// If `timings` is non-null, it is set to how long each part of advancing took.
+// If `validate_schema_changes` is false, the transaction logs are only parsed
+// if needed for the delegate or `info`, and unsupported schema changes are
+// not detected.
+// If `version` is given, advances to it rather than to the latest version.
+void advance(SharedGroup& sg, ClientHistory& history, BindingContext* delegate,
+             TransactionChangeInfo* info=nullptr, AdvanceTimings* timings=nullptr,
+             bool validate_schema_changes=true,
+             SharedGroup::VersionID version=SharedGroup::VersionID());
+
+// Advance the read transaction version to the given version, sending the
+// already-calculated change information for observed rows to delegate rather
+// than parsing the transaction log. The changes must have been calculated
+// from the current version to `version`, which also validates the schema
+// changes made between them.
+void advance(SharedGroup& sg, ClientHistory& history, BindingContext* delegate,
+             SharedGroup::VersionID version,
+             std::vector<BindingContext::ObserverState> const& observers,
+             std::vector<void*> const& invalidated,
+             AdvanceTimings* timings=nullptr);
+
+// Advance the read transaction version to the given version, or the latest
+// version if none is given, adding the row changes made between the versions
+// to `info`
+void advance(SharedGroup& sg, ClientHistory& history, TransactionChangeInfo& info,
+             SharedGroup::VersionID version=SharedGroup::VersionID());
 
 // Begin a write transaction
 // If the read transaction version is not up to date, will first advance to the
 // most recent read transaction and sent notifications to delegate
+// If `notify_if_unchanged` is false, the delegate is only notified if the
+// version was advanced, rather than whenever it observes rows
 void begin(SharedGroup& sg, ClientHistory& history, BindingContext* delegate,
-           bool validate_schema_changes=true);
+           bool validate_schema_changes=true, TransactionChangeInfo* info=nullptr,
+           bool notify_if_unchanged=true);
 
 // Commit a write transaction
 void commit(SharedGroup& sg, ClientHistory& history, BindingContext* delegate);
 
+// Get a bitmask of the tables modified by the current write transaction, in
+// the format used by CommitCounter, optionally also adding the row changes made
+// by it to `info`, setting `incompatible_schema_change` to whether it made
+// schema changes which advance() and begin() would reject, and filling in
+// everything in `stats` other than the version
+uint64_t get_modified_tables(ClientHistory& history, TransactionChangeInfo* info=nullptr,
+                             bool* incompatible_schema_change=nullptr,
+                             CommitStats* stats=nullptr);
+
 // Cancel a write transaction and roll back all changes, with change notifications
 // for reverting to the old values sent to delegate
 void cancel(SharedGroup& sg, ClientHistory& history, BindingContext* delegate);
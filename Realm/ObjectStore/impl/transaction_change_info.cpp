@@ -0,0 +1,179 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "transaction_change_info.hpp"
+
+using namespace realm;
+using namespace realm::_impl;
+
+void TableChangeInfo::set_original(size_t row_ndx, size_t original)
+{
+    m_current_valid = false;
+    if (original == row_ndx && !m_cleared) {
+        m_original.erase(row_ndx);
+    }
+    else {
+        m_original[row_ndx] = original;
+    }
+}
+
+size_t TableChangeInfo::old_index(size_t new_ndx) const
+{
+    if (m_untracked) {
+        return npos;
+    }
+    auto it = m_original.find(new_ndx);
+    if (it != m_original.end()) {
+        return it->second;
+    }
+    return m_cleared ? npos : new_ndx;
+}
+
+void TableChangeInfo::insert_rows(size_t row_ndx, size_t count, size_t prior_size)
+{
+    if (row_ndx != prior_size) {
+        // Rows are only ever appended by the object store, and tracking
+        // inserting in the middle would require shifting every later row
+        mark_untracked();
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        set_original(row_ndx + i, npos);
+    }
+}
+
+void TableChangeInfo::move_last_over(size_t row_ndx, size_t last_row_ndx)
+{
+    size_t original = old_index(row_ndx);
+    if (original != npos) {
+        m_deleted.insert(original);
+        m_modified.erase(original);
+        m_modified_columns.erase(original);
+    }
+
+    if (row_ndx != last_row_ndx) {
+        set_original(row_ndx, old_index(last_row_ndx));
+    }
+    m_original.erase(last_row_ndx);
+    m_current_valid = false;
+}
+
+void TableChangeInfo::swap_rows(size_t row_ndx_1, size_t row_ndx_2)
+{
+    size_t original_1 = old_index(row_ndx_1);
+    size_t original_2 = old_index(row_ndx_2);
+    set_original(row_ndx_1, original_2);
+    set_original(row_ndx_2, original_1);
+}
+
+void TableChangeInfo::clear()
+{
+    m_cleared = true;
+    m_original.clear();
+    m_deleted.clear();
+    m_modified.clear();
+    m_modified_columns.clear();
+    m_current_valid = false;
+}
+
+void TableChangeInfo::modify(size_t row_ndx, size_t col_ndx)
+{
+    size_t original = old_index(row_ndx);
+    if (original == npos) {
+        return;
+    }
+    m_modified.insert(original);
+    if (m_track_columns && col_ndx != npos) {
+        auto& columns = m_modified_columns[original];
+        if (columns.size() <= col_ndx) {
+            columns.resize(col_ndx + 1);
+        }
+        columns[col_ndx] = true;
+    }
+}
+
+std::vector<size_t> TableChangeInfo::inserted_rows() const
+{
+    std::vector<size_t> rows;
+    for (auto const& row : m_original) {
+        if (row.second == npos) {
+            rows.push_back(row.first);
+        }
+    }
+    return rows;
+}
+
+std::vector<bool> const* TableChangeInfo::modified_columns(size_t old_ndx) const
+{
+    auto it = m_modified_columns.find(old_ndx);
+    return it == m_modified_columns.end() ? nullptr : &it->second;
+}
+
+size_t TableChangeInfo::new_index(size_t old_ndx) const
+{
+    if (m_cleared || m_untracked || m_deleted.count(old_ndx)) {
+        return npos;
+    }
+
+    if (!m_current_valid) {
+        m_current.clear();
+        for (auto const& row : m_original) {
+            if (row.second != npos) {
+                m_current[row.second] = row.first;
+            }
+        }
+        m_current_valid = true;
+    }
+
+    auto it = m_current.find(old_ndx);
+    return it == m_current.end() ? old_ndx : it->second;
+}
+
+TableChangeInfo& TransactionChangeInfo::get(size_t table_ndx)
+{
+    if (m_tables.size() <= table_ndx) {
+        m_tables.resize(table_ndx + 1);
+    }
+    auto& table = m_tables[table_ndx];
+    if (!table) {
+        table = std::make_unique<TableChangeInfo>(m_track_columns);
+    }
+    return *table;
+}
+
+TableChangeInfo const* TransactionChangeInfo::find(size_t table_ndx) const noexcept
+{
+    return table_ndx < m_tables.size() ? m_tables[table_ndx].get() : nullptr;
+}
+
+bool TransactionChangeInfo::modified_other_than(size_t table_ndx) const noexcept
+{
+    for (size_t i = 0; i < m_tables.size(); ++i) {
+        if (i != table_ndx && m_tables[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TransactionChangeInfo::insert_table(size_t table_ndx)
+{
+    if (table_ndx < m_tables.size()) {
+        m_tables.insert(m_tables.begin() + table_ndx, nullptr);
+    }
+}
@@ -0,0 +1,125 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_TRANSACTION_CHANGE_INFO_HPP
+#define REALM_TRANSACTION_CHANGE_INFO_HPP
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace realm {
+namespace _impl {
+// Tracks what happened to each of the rows in a table over the course of one
+// or more transactions, so that rows before the transactions can be matched
+// up with rows after them.
+class TableChangeInfo {
+public:
+    static const size_t npos = size_t(-1);
+
+    // If `track_columns` is set, which columns of each row were modified is
+    // tracked in addition to which rows were
+    explicit TableChangeInfo(bool track_columns = false) : m_track_columns(track_columns) { }
+
+    // Update the tracked state for an operation in the transaction log
+    void insert_rows(size_t row_ndx, size_t count, size_t prior_size);
+    void move_last_over(size_t row_ndx, size_t last_row_ndx);
+    void swap_rows(size_t row_ndx_1, size_t row_ndx_2);
+    void clear();
+    void modify(size_t row_ndx, size_t col_ndx = npos);
+    // Operations which shift rows around in ways which aren't tracked
+    void mark_untracked() { m_untracked = true; }
+
+    // Get the current index of the row which was at `old_ndx` before the
+    // transactions, or npos if it has been deleted
+    size_t new_index(size_t old_ndx) const;
+    // Get the index before the transactions of the row which is currently at
+    // `new_ndx`, or npos if it was inserted by the transactions
+    size_t old_index(size_t new_ndx) const;
+    // Was the row at `old_ndx` before the transactions modified by them?
+    bool modified(size_t old_ndx) const { return m_modified.count(old_ndx) != 0; }
+
+    // Were all of the rows which existed before the transactions deleted, or
+    // were rows shifted in ways which weren't tracked? If so, none of the rows
+    // from before can be matched up with the current rows.
+    bool cleared() const noexcept { return m_cleared; }
+    bool untracked() const noexcept { return m_untracked; }
+
+    // Original indexes of the rows which were deleted and of the rows which
+    // were modified and not deleted
+    std::unordered_set<size_t> const& deleted_rows() const noexcept { return m_deleted; }
+    std::unordered_set<size_t> const& modified_rows() const noexcept { return m_modified; }
+    // Current indexes of the rows which were inserted, in no particular order
+    std::vector<size_t> inserted_rows() const;
+    // Which columns of the row at `old_ndx` before the transactions were
+    // modified, indexed by column and only as long as needed to hold the last
+    // one. Null if the row wasn't modified or columns aren't tracked.
+    std::vector<bool> const* modified_columns(size_t old_ndx) const;
+
+private:
+    // The original index of each row which isn't at its original index, keyed
+    // by the current index, with npos for new rows
+    std::unordered_map<size_t, size_t> m_original;
+    // Original indexes of rows which were deleted
+    std::unordered_set<size_t> m_deleted;
+    // Original indexes of rows which were modified and not deleted
+    std::unordered_set<size_t> m_modified;
+    // The modified columns of each row in m_modified, if tracked
+    std::unordered_map<size_t, std::vector<bool>> m_modified_columns;
+    bool m_track_columns;
+    // Were all of the rows which existed before the transactions deleted?
+    bool m_cleared = false;
+    // Were there changes which couldn't be tracked, such that rows from
+    // before can't be matched up with rows after?
+    bool m_untracked = false;
+
+    // Inverse of m_original, built when it's first needed
+    mutable std::unordered_map<size_t, size_t> m_current;
+    mutable bool m_current_valid = false;
+
+    void set_original(size_t row_ndx, size_t original);
+};
+
+// The row changes made to each table in a Realm by one or more transactions
+class TransactionChangeInfo {
+public:
+    // See TableChangeInfo's constructor
+    explicit TransactionChangeInfo(bool track_columns = false) : m_track_columns(track_columns) { }
+
+    // Get the change info for the table, creating it if needed
+    TableChangeInfo& get(size_t table_ndx);
+    // Get the change info for the table, or nullptr if it wasn't modified
+    TableChangeInfo const* find(size_t table_ndx) const noexcept;
+    // Were any tables other than the given one modified?
+    bool modified_other_than(size_t table_ndx) const noexcept;
+
+    // A table was inserted at the given index, shifting later tables
+    void insert_table(size_t table_ndx);
+
+    void clear() noexcept { m_tables.clear(); }
+
+private:
+    // Indexed by table index, with null entries for unmodified tables
+    std::vector<std::unique_ptr<TableChangeInfo>> m_tables;
+    bool m_track_columns;
+};
+} // namespace _impl
+} // namespace realm
+
+#endif /* REALM_TRANSACTION_CHANGE_INFO_HPP */
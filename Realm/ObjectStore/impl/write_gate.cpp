@@ -0,0 +1,112 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "write_gate.hpp"
+
+#include <algorithm>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+using namespace realm;
+using namespace realm::_impl;
+
+std::shared_ptr<WriteGate> WriteGate::get(std::string const& realm_path)
+{
+    static std::mutex s_mutex;
+    static auto& s_gates = *new std::unordered_map<std::string, std::weak_ptr<WriteGate>>;
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    auto& weak_gate = s_gates[realm_path];
+    auto gate = weak_gate.lock();
+    if (!gate) {
+        gate = std::make_shared<WriteGate>(realm_path);
+        weak_gate = gate;
+    }
+    return gate;
+}
+
+WriteGate::WriteGate(std::string const& realm_path)
+{
+    std::string path = realm_path + ".write";
+    m_fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (m_fd == -1) {
+        throw std::system_error(errno, std::system_category());
+    }
+}
+
+WriteGate::~WriteGate()
+{
+    close(m_fd);
+}
+
+void WriteGate::lock()
+{
+    m_mutex.lock();
+    int ret;
+    do {
+        ret = flock(m_fd, LOCK_EX);
+    } while (ret == -1 && errno == EINTR);
+    if (ret == -1) {
+        int err = errno;
+        m_mutex.unlock();
+        throw std::system_error(err, std::system_category());
+    }
+}
+
+bool WriteGate::try_lock_for(std::chrono::milliseconds timeout)
+{
+    using clock = std::chrono::steady_clock;
+    auto deadline = clock::now() + timeout;
+    if (!m_mutex.try_lock_until(deadline)) {
+        return false;
+    }
+
+    // Another process holds the lock for about as long as a write transaction
+    // takes, so start polling quickly and back off to a few milliseconds
+    auto delay = std::chrono::microseconds(50);
+    while (flock(m_fd, LOCK_EX | LOCK_NB) == -1) {
+        int err = errno;
+        if (err == EINTR) {
+            continue;
+        }
+        if (err != EWOULDBLOCK) {
+            m_mutex.unlock();
+            throw std::system_error(err, std::system_category());
+        }
+
+        auto now = clock::now();
+        if (now >= deadline) {
+            m_mutex.unlock();
+            return false;
+        }
+        std::this_thread::sleep_for(std::min<clock::duration>(delay, deadline - now));
+        delay = std::min(delay * 2, std::chrono::microseconds(5000));
+    }
+    return true;
+}
+
+void WriteGate::unlock()
+{
+    flock(m_fd, LOCK_UN);
+    m_mutex.unlock();
+}
@@ -0,0 +1,66 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_WRITE_GATE_HPP
+#define REALM_WRITE_GATE_HPP
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace realm {
+namespace _impl {
+// An advisory lock which every Realm instance acquires before the write lock
+// in core and holds until its write transaction ends. Core's write lock can
+// only be waited on indefinitely, while this one can be waited on with a
+// timeout, which is what lets try_begin_transaction() give up without
+// blocking in core.
+//
+// Threads in this process are serialized with a timed mutex, and processes
+// with flock() on a file next to the Realm file. flock() can't be waited on
+// with a timeout either, so that part is polled with a backoff. Writers which
+// don't use the gate (such as older versions of this library) are still
+// excluded by core's write lock, but may make try_begin_transaction() block
+// past its timeout.
+//
+// Satisfies TimedLockable, so it can be used with std::unique_lock.
+class WriteGate {
+public:
+    // Get the gate for the given Realm file path, which is shared by every
+    // Realm instance for the path in this process
+    static std::shared_ptr<WriteGate> get(std::string const& realm_path);
+
+    WriteGate(std::string const& realm_path);
+    ~WriteGate();
+
+    void lock();
+    bool try_lock_for(std::chrono::milliseconds timeout);
+    void unlock();
+
+private:
+    std::timed_mutex m_mutex;
+    int m_fd = -1;
+
+    WriteGate(WriteGate const&) = delete;
+    WriteGate& operator=(WriteGate const&) = delete;
+};
+} // namespace _impl
+} // namespace realm
+
+#endif /* REALM_WRITE_GATE_HPP */
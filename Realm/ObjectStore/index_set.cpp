@@ -18,75 +18,656 @@
 
 #include "index_set.hpp"
 
+#include <algorithm>
+
 using namespace realm;
 
-IndexSet::iterator IndexSet::find(size_t index)
+namespace {
+// Set the bits [begin, end), which must be within the vector, returning the
+// number of bits which weren't already set
+size_t set_bits(std::vector<uint64_t>& bits, size_t begin, size_t end)
+{
+    size_t first = begin / 64, last = (end - 1) / 64;
+    uint64_t first_mask = ~uint64_t(0) << (begin % 64);
+    uint64_t last_mask = ~uint64_t(0) >> (63 - (end - 1) % 64);
+    if (first == last) {
+        first_mask &= last_mask;
+    }
+
+    size_t added = 0;
+    auto set = [&](size_t ndx, uint64_t mask) {
+        added += __builtin_popcountll(mask & ~bits[ndx]);
+        bits[ndx] |= mask;
+    };
+    set(first, first_mask);
+    if (first != last) {
+        for (size_t i = first + 1; i < last; ++i) {
+            set(i, ~uint64_t(0));
+        }
+        set(last, last_mask);
+    }
+    return added;
+}
+
+// Find the first bit at or after `pos` which is set (or unset), or the number
+// of bits if there is none
+inline size_t find_bit(std::vector<uint64_t> const& bits, size_t pos, bool set)
+{
+    size_t ndx = pos / 64;
+    if (ndx >= bits.size()) {
+        return bits.size() * 64;
+    }
+    uint64_t word = (set ? bits[ndx] : ~bits[ndx]) & (~uint64_t(0) << (pos % 64));
+    while (!word) {
+        if (++ndx == bits.size()) {
+            return bits.size() * 64;
+        }
+        word = set ? bits[ndx] : ~bits[ndx];
+    }
+    return ndx * 64 + __builtin_ctzll(word);
+}
+
+// Read the 64 bits starting at `pos`, treating bits outside of the vector
+// (including before the start of it) as unset
+uint64_t read_word(std::vector<uint64_t> const& bits, ptrdiff_t pos)
+{
+    if (pos <= -64) {
+        return 0;
+    }
+    if (pos < 0) {
+        return bits[0] << -pos;
+    }
+    size_t ndx = pos / 64, shift = pos % 64;
+    uint64_t low = ndx < bits.size() ? bits[ndx] : 0;
+    if (shift == 0) {
+        return low;
+    }
+    uint64_t high = ndx + 1 < bits.size() ? bits[ndx + 1] : 0;
+    return (low >> shift) | (high << (64 - shift));
+}
+} // anonymous namespace
+
+size_t IndexSet::Chunk::first() const
+{
+    if (is_bitmap()) {
+        return __builtin_ctzll(bits.front());
+    }
+    return ranges.front().first;
+}
+
+size_t IndexSet::Chunk::last_end() const
+{
+    if (is_bitmap()) {
+        return bits.size() * 64 - __builtin_clzll(bits.back());
+    }
+    return ranges.back().second;
+}
+
+bool IndexSet::Chunk::contains(size_t index) const
+{
+    if (is_bitmap()) {
+        return index / 64 < bits.size() && (bits[index / 64] >> (index % 64)) & 1;
+    }
+    auto it = std::lower_bound(ranges.begin(), ranges.end(), index,
+                               [](auto const& range, size_t index) { return range.second <= index; });
+    return it != ranges.end() && it->first <= index;
+}
+
+size_t IndexSet::Chunk::range_count() const
+{
+    if (!is_bitmap()) {
+        return ranges.size();
+    }
+    // Count the set bits whose previous bit is unset
+    size_t count = 0;
+    uint64_t carry = 0;
+    for (auto word : bits) {
+        count += __builtin_popcountll(word & ~((word << 1) | carry));
+        carry = word >> 63;
+    }
+    return count;
+}
+
+size_t IndexSet::Chunk::index_count() const
+{
+    size_t count = 0;
+    for (auto word : bits) {
+        count += __builtin_popcountll(word);
+    }
+    for (auto const& range : ranges) {
+        count += range.second - range.first;
+    }
+    return count;
+}
+
+size_t IndexSet::Chunk::add_range(size_t begin, size_t end)
+{
+    if (is_bitmap()) {
+        if (end > bits.size() * 64) {
+            bits.resize((end + 63) / 64);
+        }
+        return set_bits(bits, begin, end);
+    }
+
+    auto it = std::lower_bound(ranges.begin(), ranges.end(), begin,
+                               [](auto const& range, size_t index) { return range.second < index; });
+    if (it == ranges.end() || it->first > end) {
+        // Not adjacent to or overlapping any existing ranges
+        ranges.insert(it, {begin, end});
+        return end - begin;
+    }
+
+    // Merge with all of the ranges it overlaps or touches
+    size_t previous = it->second - it->first;
+    it->first = std::min(it->first, begin);
+    it->second = std::max(it->second, end);
+    auto last = it + 1;
+    while (last != ranges.end() && last->first <= it->second) {
+        previous += last->second - last->first;
+        it->second = std::max(it->second, last->second);
+        ++last;
+    }
+    ranges.erase(it + 1, last);
+    return it->second - it->first - previous;
+}
+
+void IndexSet::Chunk::insert_at(size_t index, size_t count)
+{
+    if (!is_bitmap()) {
+        for (auto& range : ranges) {
+            if (range.second <= index) {
+                continue;
+            }
+            // A range containing the insertion point is extended to cover the
+            // inserted indexes, and later ones are shifted
+            if (range.first >= index) {
+                range.first += count;
+            }
+            range.second += count;
+        }
+        return;
+    }
+
+    // Move each word after the insertion point back, working from the end so
+    // that the words being read from haven't been overwritten yet
+    size_t first = index / 64, dest = index + count;
+    uint64_t before = bits[first] & ((uint64_t(1) << (index % 64)) - 1);
+    bits.resize((last_end() + count + 63) / 64);
+    for (size_t i = bits.size(); i-- > dest / 64;) {
+        uint64_t word = read_word(bits, ptrdiff_t(i * 64) - ptrdiff_t(count));
+        if (i * 64 < dest) {
+            word &= ~uint64_t(0) << (dest - i * 64);
+        }
+        bits[i] = word;
+    }
+    std::fill(bits.begin() + first, bits.begin() + dest / 64, 0);
+    bits[first] |= before;
+}
+
+size_t IndexSet::Chunk::remove_prefix(size_t end)
+{
+    if (!is_bitmap()) {
+        auto it = ranges.begin();
+        while (it != ranges.end() && it->first <= end) {
+            end = std::max(end, it->second);
+            ++it;
+        }
+        ranges.erase(ranges.begin(), it);
+        return end;
+    }
+
+    if (contains(end)) {
+        end = find_bit(bits, end, false);
+    }
+    size_t first_word = end / 64;
+    if (first_word < bits.size()) {
+        bits[first_word] &= ~uint64_t(0) << (end % 64);
+    }
+    // Drop the words which are now empty from the front, keeping the first
+    // word non-zero
+    while (first_word < bits.size() && !bits[first_word]) {
+        ++first_word;
+    }
+    first_word = std::min(first_word, bits.size());
+    bits.erase(bits.begin(), bits.begin() + first_word);
+    offset += first_word * 64;
+    return end;
+}
+
+size_t IndexSet::Chunk::shift_index(size_t index, size_t offset) const
+{
+    if (!is_bitmap()) {
+        for (auto const& range : ranges) {
+            if (offset + range.first > index) {
+                break;
+            }
+            index += range.second - range.first;
+        }
+        return index;
+    }
+
+    for (size_t i = 0; i < bits.size(); ++i) {
+        size_t base = offset + i * 64;
+        if (base > index) {
+            break;
+        }
+        // Each set bit at or before the index moves the index forward, which
+        // can bring more of the word's bits before it
+        size_t counted = 0;
+        while (true) {
+            size_t limit = index - base;
+            uint64_t mask = limit >= 63 ? ~uint64_t(0) : (uint64_t(2) << limit) - 1;
+            size_t count = __builtin_popcountll(bits[i] & mask);
+            if (count == counted) {
+                break;
+            }
+            index += count - counted;
+            counted = count;
+        }
+    }
+    return index;
+}
+
+bool IndexSet::Chunk::next_range(size_t& position, value_type& range) const
+{
+    if (!is_bitmap()) {
+        position = position == npos ? 0 : position + 1;
+        if (position == ranges.size()) {
+            return false;
+        }
+        range = ranges[position];
+        return true;
+    }
+
+    size_t begin = position == npos ? first() : find_bit(bits, range.second, true);
+    if (begin == bits.size() * 64) {
+        return false;
+    }
+    position = begin;
+    range = {begin, find_bit(bits, begin, false)};
+    return true;
+}
+
+void IndexSet::Chunk::convert_to_bitmap()
+{
+    // Keep the offset word-aligned relative to where it was so that the
+    // ranges don't need to be shifted within words
+    size_t base = first() & ~size_t(63);
+    std::vector<uint64_t> new_bits((last_end() - base + 63) / 64);
+    for (auto const& range : ranges) {
+        set_bits(new_bits, range.first - base, range.second - base);
+    }
+    offset += base;
+    bits = std::move(new_bits);
+    std::vector<value_type>().swap(ranges);
+}
+
+void IndexSet::Chunk::convert_to_ranges()
+{
+    std::vector<value_type> new_ranges;
+    new_ranges.reserve(range_count());
+    size_t position = npos;
+    value_type range;
+    while (next_range(position, range)) {
+        new_ranges.push_back(range);
+    }
+    ranges = std::move(new_ranges);
+    std::vector<uint64_t>().swap(bits);
+}
+
+IndexSet::Chunk IndexSet::Chunk::split()
+{
+    if (!is_bitmap()) {
+        auto mid = ranges.begin() + ranges.size() / 2;
+        size_t base = mid->first;
+        Chunk second{std::vector<value_type>(mid, ranges.end()), {}, offset + base, 0};
+        for (auto& range : second.ranges) {
+            range.first -= base;
+            range.second -= base;
+        }
+        ranges.erase(mid, ranges.end());
+        second.count = second.index_count();
+        count -= second.count;
+        return second;
+    }
+
+    size_t mid = bits.size() / 2;
+    Chunk second{{}, std::vector<uint64_t>(bits.begin() + mid, bits.end()), offset + mid * 64, 0};
+    bits.erase(bits.begin() + mid, bits.end());
+
+    // Trim the empty words at the end of the first half and the start of the
+    // second half
+    while (!bits.back()) {
+        bits.pop_back();
+    }
+    size_t leading = 0;
+    while (!second.bits[leading]) {
+        ++leading;
+    }
+    second.bits.erase(second.bits.begin(), second.bits.begin() + leading);
+    second.offset += leading * 64;
+
+    second.count = second.index_count();
+    count -= second.count;
+
+    // Halves which turned out to be sparse are smaller as ranges
+    for (auto chunk : {this, &second}) {
+        if (chunk->bits.size() >= chunk->range_count() * 2) {
+            chunk->convert_to_ranges();
+        }
+    }
+    return second;
+}
+
+void IndexSet::SumTree::add(size_t ndx, size_t delta)
+{
+    for (; ndx < m_tree.size(); ndx |= ndx + 1) {
+        m_tree[ndx] += delta;
+    }
+}
+
+size_t IndexSet::SumTree::sum(size_t count) const
+{
+    size_t sum = 0;
+    for (; count > 0; count &= count - 1) {
+        sum += m_tree[count - 1];
+    }
+    return sum;
+}
+
+void IndexSet::update_count(size_t ndx)
+{
+    auto& chunk = m_chunks[ndx];
+    size_t count = chunk.index_count();
+    m_counts.add(ndx, count - chunk.count);
+    chunk.count = count;
+}
+
+void IndexSet::add_to_chunk(size_t ndx, size_t begin, size_t end)
+{
+    size_t added = m_chunks[ndx].add_range(begin, end);
+    m_chunks[ndx].count += added;
+    m_counts.add(ndx, added);
+}
+
+void IndexSet::ensure_bitmap_can_hold(size_t ndx, size_t begin, size_t end)
+{
+    auto& chunk = m_chunks[ndx];
+    if (!chunk.is_bitmap()) {
+        return;
+    }
+    size_t offset = chunk_offset(ndx);
+    size_t low = std::min(begin, offset), high = std::max(end, offset + chunk.last_end());
+    if ((high - low + 63) / 64 > max_bitmap_words) {
+        chunk.convert_to_ranges();
+    }
+}
+
+void IndexSet::flatten_shifts()
+{
+    for (size_t i = 0; i < m_chunks.size(); ++i) {
+        m_chunks[i].offset += m_shifts.sum(i + 1);
+    }
+    m_shifts.reset(m_chunks.size());
+}
+
+void IndexSet::rebuild_trees()
 {
-    for (auto it = m_ranges.begin(), end = m_ranges.end(); it != end; ++it) {
-        if (it->second > index)
-            return it;
+    m_shifts.reset(m_chunks.size());
+    m_counts.build(m_chunks.size(), [&](size_t i) { return m_chunks[i].count; });
+}
+
+size_t IndexSet::find_chunk(size_t index, bool inclusive) const
+{
+    size_t begin = 0, end = m_chunks.size();
+    while (begin < end) {
+        size_t mid = begin + (end - begin) / 2;
+        size_t mid_end = chunk_end(mid);
+        if (mid_end < index || (mid_end == index && !inclusive)) {
+            begin = mid + 1;
+        }
+        else {
+            end = mid;
+        }
+    }
+    return begin;
+}
+
+size_t IndexSet::size() const
+{
+    size_t size = 0;
+    for (auto const& chunk : m_chunks) {
+        size += chunk.range_count();
     }
-    return m_ranges.end();
+    return size;
+}
+
+bool IndexSet::contains(size_t index) const
+{
+    size_t ndx = find_chunk(index);
+    if (ndx == m_chunks.size() || chunk_begin(ndx) > index) {
+        return false;
+    }
+    return m_chunks[ndx].contains(index - chunk_offset(ndx));
 }
 
 void IndexSet::add(size_t index)
 {
-    do_add(find(index), index);
+    add_range(index, index + 1);
+}
+
+void IndexSet::add(IndexSet const& other)
+{
+    for (auto range : other) {
+        add_range(range.first, range.second);
+    }
 }
 
-void IndexSet::do_add(iterator it, size_t index)
+void IndexSet::add_range(size_t begin, size_t end)
 {
-    bool more_before = it != m_ranges.begin(), valid = it != m_ranges.end();
-    if (valid && it->first <= index && it->second > index) {
-        // index is already in set
+    if (begin >= end) {
+        return;
+    }
+    if (m_chunks.empty()) {
+        m_chunks.push_back({{{0, end - begin}}, {}, begin, end - begin});
+        rebuild_trees();
+        return;
     }
-    else if (more_before && (it - 1)->second == index) {
-        // index is immediately after an existing range
-        ++(it - 1)->second;
+
+    // Find the first chunk whose last range is at or after the new range,
+    // including ones which end exactly where the new range begins so that
+    // they can be merged. If the new range is after all of the existing ones
+    // it goes at the end of the last chunk.
+    size_t ndx = std::min(find_chunk(begin, true), m_chunks.size() - 1);
+    ensure_bitmap_can_hold(ndx, begin, end);
+    size_t offset = chunk_offset(ndx);
+    if (begin < offset) {
+        // Move the chunk's offset down to the start of the new range
+        m_chunks[ndx].insert_at(0, offset - begin);
+        m_chunks[ndx].offset -= offset - begin;
+        offset = begin;
     }
-    else if (more_before && valid && (it - 1)->second == it->first) {
-        // index joins two existing ranges
-        (it - 1)->second = it->second;
-        m_ranges.erase(it);
+    add_to_chunk(ndx, begin - offset, end - offset);
+
+    merge_with_next(ndx);
+    split_if_needed(ndx);
+}
+
+void IndexSet::merge_with_next(size_t ndx)
+{
+    while (ndx + 1 < m_chunks.size()) {
+        size_t end = chunk_end(ndx);
+        if (chunk_begin(ndx + 1) > end) {
+            return;
+        }
+
+        // Absorb the ranges of the next chunk which overlap or touch the last
+        // range of this one
+        size_t next_offset = chunk_offset(ndx + 1);
+        size_t new_end = m_chunks[ndx + 1].remove_prefix(end - next_offset) + next_offset;
+        if (new_end > end) {
+            ensure_bitmap_can_hold(ndx, end, new_end);
+            size_t offset = chunk_offset(ndx);
+            add_to_chunk(ndx, end - offset, new_end - offset);
+        }
+
+        if (!m_chunks[ndx + 1].empty()) {
+            update_count(ndx + 1);
+            return;
+        }
+        // The next chunk was entirely absorbed, so check the one after it
+        flatten_shifts();
+        m_chunks.erase(m_chunks.begin() + ndx + 1);
+        rebuild_trees();
     }
-    else if (valid && it->first == index + 1) {
-        // index is immediately before an existing range
-        --it->first;
+}
+
+void IndexSet::split_if_needed(size_t ndx)
+{
+    auto& chunk = m_chunks[ndx];
+    if (chunk.is_bitmap()) {
+        if (chunk.bits.size() <= max_bitmap_words) {
+            return;
+        }
     }
     else {
-        // index is not next to an existing range
-        m_ranges.insert(it, {index, index + 1});
+        if (chunk.ranges.size() <= max_chunk_size) {
+            return;
+        }
+        // Many short ranges close together take less space as a bitmap
+        size_t words = (chunk.last_end() - (chunk.first() & ~size_t(63)) + 63) / 64;
+        if (words <= max_bitmap_words && words < chunk.ranges.size() * 2) {
+            chunk.convert_to_bitmap();
+            return;
+        }
     }
+
+    // Adding a chunk changes the position of every chunk after it in the
+    // trees, so they have to be rebuilt. This happens at most once per
+    // max_chunk_size / 2 ranges added.
+    flatten_shifts();
+    Chunk second = chunk.split();
+    m_chunks.insert(m_chunks.begin() + ndx + 1, std::move(second));
+    rebuild_trees();
+
+    // A chunk which was converted from a bitmap may need splitting more than
+    // once
+    split_if_needed(ndx + 1);
+    split_if_needed(ndx);
 }
 
 void IndexSet::set(size_t len)
 {
-    m_ranges.clear();
+    clear();
     if (len) {
-        m_ranges.push_back({0, len});
+        add_range(0, len);
     }
 }
 
-void IndexSet::insert_at(size_t index)
+void IndexSet::clear()
+{
+    m_chunks.clear();
+    rebuild_trees();
+}
+
+void IndexSet::insert_at(size_t index, size_t count)
 {
-    auto pos = find(index);
-    if (pos != m_ranges.end()) {
-        if (pos->first >= index)
-            ++pos->first;
-        ++pos->second;
-        for (auto it = pos + 1; it != m_ranges.end(); ++it) {
-            ++it->first;
-            ++it->second;
+    if (count == 0) {
+        return;
+    }
+
+    size_t ndx = find_chunk(index);
+    if (ndx != m_chunks.size()) {
+        size_t offset = chunk_offset(ndx);
+        if (offset + m_chunks[ndx].first() < index) {
+            ensure_bitmap_can_hold(ndx, index, chunk_end(ndx) + count);
+            m_chunks[ndx].insert_at(index - offset, count);
+            update_count(ndx);
+            ++ndx;
+        }
+
+        // Later chunks only need their offset shifted, which is recorded at
+        // the first one to shift
+        if (ndx != m_chunks.size()) {
+            m_shifts.add(ndx, count);
         }
     }
-    do_add(pos, index);
+
+    add_range(index, index + count);
 }
 
 void IndexSet::add_shifted(size_t index)
 {
-    auto it = m_ranges.begin();
-    for (auto end = m_ranges.end(); it != end && it->first <= index; ++it) {
-        index += it->second - it->first;
+    // The number of indexes not in the set which are before the end of each
+    // chunk never decreases from one chunk to the next, so the chunk which
+    // the shifted index falls in can be binary searched for: it's the first
+    // one where that's greater than the unshifted index
+    size_t begin = 0, end = m_chunks.size();
+    while (begin < end) {
+        size_t mid = begin + (end - begin) / 2;
+        if (chunk_end(mid) - m_counts.sum(mid + 1) <= index) {
+            begin = mid + 1;
+        }
+        else {
+            end = mid;
+        }
+    }
+
+    index += m_counts.sum(begin);
+    if (begin < m_chunks.size()) {
+        index = m_chunks[begin].shift_index(index, chunk_offset(begin));
+    }
+    add(index);
+}
+
+IndexSet::const_iterator IndexSet::begin() const
+{
+    return const_iterator(*this, 0);
+}
+
+IndexSet::const_iterator IndexSet::end() const
+{
+    return const_iterator(*this, m_chunks.size());
+}
+
+IndexSet::const_iterator::const_iterator(IndexSet const& set, size_t chunk)
+: m_set(&set)
+, m_chunk(chunk)
+{
+    if (m_chunk < set.m_chunks.size()) {
+        m_range = Chunk::npos;
+        m_offset = set.chunk_offset(m_chunk);
+        set.m_chunks[m_chunk].next_range(m_range, m_value);
     }
-    do_add(it, index);
+}
+
+IndexSet::value_type IndexSet::const_iterator::operator*() const
+{
+    return {m_value.first + m_offset, m_value.second + m_offset};
+}
+
+IndexSet::const_iterator& IndexSet::const_iterator::operator++()
+{
+    if (!m_set->m_chunks[m_chunk].next_range(m_range, m_value)) {
+        next_chunk();
+    }
+    return *this;
+}
+
+void IndexSet::const_iterator::next_chunk()
+{
+    m_range = 0;
+    if (++m_chunk == m_set->m_chunks.size()) {
+        return;
+    }
+    m_range = Chunk::npos;
+    m_offset = m_set->chunk_offset(m_chunk);
+    m_set->m_chunks[m_chunk].next_range(m_range, m_value);
+}
+
+IndexSet::const_iterator IndexSet::const_iterator::operator++(int)
+{
+    auto ret = *this;
+    ++*this;
+    return ret;
 }
@@ -19,44 +19,241 @@
 #ifndef REALM_INDEX_SET_HPP
 #define REALM_INDEX_SET_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
 #include <vector>
 
 namespace realm {
+// A set of indexes, stored as sorted ranges of adjacent indexes.
+//
+// The ranges are split into chunks of at most `max_chunk_size` ranges, each
+// storing its ranges relative to an offset. Finding the chunk containing an
+// index is a binary search and changes within a chunk only touch that chunk.
+// The offsets of the chunks after a point being shifted and the number of
+// indexes in the chunks before a point are tracked with binary indexed trees
+// over the chunks, so shifting all of the indexes after a point and skipping
+// over the indexes before one are logarithmic in the number of chunks rather
+// than linear.
+//
+// Chunks which would otherwise have to be split because they have many
+// short ranges close together are instead stored as a bitmap of up to
+// `max_bitmap_words` words if that's smaller, which is operated on a word at
+// a time. Bitmap chunks which become sparse when split go back to ranges.
 class IndexSet {
 public:
+    static const size_t max_chunk_size = 128;
+    static const size_t max_bitmap_words = max_chunk_size * 2;
+
+    // The ranges are [first, second)
     using value_type = std::pair<size_t, size_t>;
-    using iterator = std::vector<value_type>::iterator;
-    using const_iterator = std::vector<value_type>::const_iterator;
 
-    const_iterator begin() const { return m_ranges.begin(); }
-    const_iterator end() const { return m_ranges.end(); }
-    bool empty() const { return m_ranges.empty(); }
-    size_t size() const { return m_ranges.size(); }
+private:
+    struct Chunk {
+        // The ranges in this chunk, relative to the chunk's offset, if it's
+        // stored as ranges
+        std::vector<value_type> ranges;
+        // If non-empty, the chunk is stored as a bitmap instead, with bit `i`
+        // set if `offset + i` is in the set. The first and last words are
+        // never zero.
+        std::vector<uint64_t> bits;
+        // The chunk's offset, excluding any shifts recorded in m_shifts
+        size_t offset;
+        // The number of indexes in this chunk
+        size_t count;
+
+        static const size_t npos = -1;
+
+        bool empty() const { return ranges.empty() && bits.empty(); }
+        bool is_bitmap() const { return !bits.empty(); }
+
+        // All of the following positions are relative to the offset
+
+        // The first index in the chunk, and one past the last index
+        size_t first() const;
+        size_t last_end() const;
+        bool contains(size_t index) const;
+        // The number of ranges and indexes in the chunk
+        size_t range_count() const;
+        size_t index_count() const;
+
+        // Add a range which does not start before the offset, returning the
+        // number of indexes which weren't already present
+        size_t add_range(size_t begin, size_t end);
+        // Shift the indexes at or after `index` back by `count`, leaving the
+        // indexes inserted to be added by the caller
+        void insert_at(size_t index, size_t count);
+        // Remove all of the ranges which start at or before `end`, returning
+        // the end of the last one removed or `end` if that's greater
+        size_t remove_prefix(size_t end);
+        // The equivalent of IndexSet::add_shifted() for an index which has
+        // already been shifted past all of the chunks before this one, where
+        // both `index` and `offset` are absolute
+        size_t shift_index(size_t index, size_t offset) const;
+
+        // Get the first range in the chunk if `position` is npos, or the one
+        // after `range`, which is at `position`, otherwise. Returns false if
+        // there are no more ranges. The position is the index in `ranges`, or
+        // the first bit of the range for bitmaps.
+        bool next_range(size_t& position, value_type& range) const;
+
+        void convert_to_bitmap();
+        void convert_to_ranges();
+        // Move the second half of this chunk to a new chunk
+        Chunk split();
+    };
+
+    // A binary indexed tree of sums over the chunks, with logarithmic
+    // updates of a single element and sums of a prefix. Values are unsigned
+    // and wrap around, so subtracting is done by adding the negated value.
+    class SumTree {
+    public:
+        // Set the size of the tree, with all values zero
+        void reset(size_t size) { m_tree.assign(size, 0); }
+        // Set the size of the tree and the value of each element
+        template<typename Func>
+        void build(size_t size, Func&& value);
+
+        // Add `delta` to the element at `ndx`
+        void add(size_t ndx, size_t delta);
+        // Get the sum of the first `count` elements
+        size_t sum(size_t count) const;
+
+    private:
+        std::vector<size_t> m_tree;
+    };
+
+public:
+    class const_iterator;
+    using iterator = const_iterator;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+    bool empty() const { return m_chunks.empty(); }
+    // The number of ranges in the set
+    size_t size() const;
+    // The number of indexes in the set
+    size_t count() const { return m_counts.sum(m_chunks.size()); }
+
+    // Check if the index is in the set
+    bool contains(size_t index) const;
 
     // Add an index to the set, doing nothing if it's already present
     void add(size_t index);
+    // Add the indexes in the range [begin, end)
+    void add_range(size_t begin, size_t end);
+    // Add all of the indexes in another set
+    void add(IndexSet const& other);
 
     // Remove all indexes from the set and then add a single range starting from
     // zero with the given length
     void set(size_t len);
 
-    // Insert an index at the given position, shifting existing indexes at or
-    // after that point back by one
-    void insert_at(size_t index);
+    // Remove all indexes from the set
+    void clear();
+
+    // Insert `count` indexes at the given position, shifting existing indexes
+    // at or after that point back by `count`
+    void insert_at(size_t index, size_t count = 1);
 
     // Add an index which has had all of the ranges in the set before it removed
     void add_shifted(size_t index);
 
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = IndexSet::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = value_type const*;
+        using reference = value_type;
+
+        const_iterator() = default;
+
+        value_type operator*() const;
+        // Ranges are computed from the chunk offset, so -> returns a proxy
+        // which holds the range by value
+        struct arrow_proxy {
+            value_type value;
+            value_type const* operator->() const { return &value; }
+        };
+        arrow_proxy operator->() const { return {**this}; }
+
+        const_iterator& operator++();
+        const_iterator operator++(int);
+
+        bool operator==(const_iterator const& other) const
+        {
+            return m_chunk == other.m_chunk && m_range == other.m_range;
+        }
+        bool operator!=(const_iterator const& other) const { return !(*this == other); }
+
+    private:
+        friend class IndexSet;
+        IndexSet const* m_set = nullptr;
+        size_t m_chunk = 0;
+        size_t m_range = 0;
+        // The offset of the current chunk and the current range in it,
+        // relative to that offset
+        size_t m_offset = 0;
+        value_type m_value;
+
+        void next_chunk();
+
+        const_iterator(IndexSet const& set, size_t chunk);
+    };
+
 private:
-    std::vector<value_type> m_ranges;
-
-    // Find the range which contains the index, or the first one after it if
-    // none do
-    iterator find(size_t index);
-    // Insert the index before the given position, combining existing ranges as
-    // applicable
-    void do_add(iterator pos, size_t index);
+    std::vector<Chunk> m_chunks;
+    // The amount each chunk has been shifted by insert_at() since the chunks
+    // were last restructured, with a shift of all chunks from a point onwards
+    // stored at the first chunk it applies to
+    SumTree m_shifts;
+    // The number of indexes in each chunk
+    SumTree m_counts;
+
+    size_t chunk_offset(size_t ndx) const { return m_chunks[ndx].offset + m_shifts.sum(ndx + 1); }
+    size_t chunk_begin(size_t ndx) const { return chunk_offset(ndx) + m_chunks[ndx].first(); }
+    size_t chunk_end(size_t ndx) const { return chunk_offset(ndx) + m_chunks[ndx].last_end(); }
+
+    // Find the first chunk which ends after the index (or at it, if
+    // `inclusive` is set), or m_chunks.size() if there is none
+    size_t find_chunk(size_t index, bool inclusive = false) const;
+
+    // Recalculate the count of a chunk after its ranges have been modified
+    void update_count(size_t ndx);
+    // Add a range relative to the chunk's offset to the chunk
+    void add_to_chunk(size_t ndx, size_t begin, size_t end);
+    // Convert a bitmap chunk to ranges if covering [begin, end) would make it
+    // too large
+    void ensure_bitmap_can_hold(size_t ndx, size_t begin, size_t end);
+
+    // Fold the pending shifts into the chunks' offsets before adding or
+    // removing chunks, and rebuild the trees to match afterwards
+    void flatten_shifts();
+    void rebuild_trees();
+
+    // Merge any ranges at the start of the chunk after `ndx` which overlap or
+    // are adjacent to the last range in `ndx` into it
+    void merge_with_next(size_t ndx);
+    // Convert the chunk to a bitmap or split it if it's grown too large
+    void split_if_needed(size_t ndx);
 };
+
+template<typename Func>
+void IndexSet::SumTree::build(size_t size, Func&& value)
+{
+    m_tree.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+        m_tree[i] = value(i);
+    }
+    for (size_t i = 0; i < size; ++i) {
+        size_t parent = i | (i + 1);
+        if (parent < size) {
+            m_tree[parent] += m_tree[i];
+        }
+    }
+}
 } // namespace realm
 
 #endif // REALM_INDEX_SET_HPP
@@ -0,0 +1,105 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_LATENCY_HISTOGRAM_HPP
+#define REALM_LATENCY_HISTOGRAM_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace realm {
+// A lock-free histogram of durations with power-of-two sized buckets, cheap
+// enough to record into on hot paths. Buckets are in nanoseconds, with bucket
+// N holding samples in the range [2^(N-1), 2^N).
+class LatencyHistogram {
+public:
+    using clock = std::chrono::steady_clock;
+    static const size_t bucket_count = 64;
+
+    // Record a single sample
+    void record(clock::duration duration) noexcept
+    {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        uint64_t value = ns > 0 ? static_cast<uint64_t>(ns) : 0;
+
+        m_buckets[bucket_for(value)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_total.fetch_add(value, std::memory_order_relaxed);
+
+        uint64_t max = m_max.load(std::memory_order_relaxed);
+        while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) { }
+    }
+
+    // Record the time elapsed since `start`
+    void record_since(clock::time_point start) noexcept { record(clock::now() - start); }
+
+    uint64_t count() const noexcept { return m_count.load(std::memory_order_relaxed); }
+    std::chrono::nanoseconds total() const noexcept { return std::chrono::nanoseconds(m_total.load(std::memory_order_relaxed)); }
+    std::chrono::nanoseconds max() const noexcept { return std::chrono::nanoseconds(m_max.load(std::memory_order_relaxed)); }
+    std::chrono::nanoseconds mean() const noexcept
+    {
+        auto c = count();
+        return c ? std::chrono::nanoseconds(total().count() / static_cast<int64_t>(c)) : std::chrono::nanoseconds(0);
+    }
+
+    // Get an upper bound on the given percentile (0-100), accurate to within a
+    // factor of two
+    std::chrono::nanoseconds percentile(double p) const noexcept
+    {
+        uint64_t target = static_cast<uint64_t>(count() * p / 100.0);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < bucket_count; ++i) {
+            seen += m_buckets[i].load(std::memory_order_relaxed);
+            if (seen > target)
+                return std::chrono::nanoseconds(i == 0 ? 0 : (i == 63 ? INT64_MAX : int64_t(1) << i));
+        }
+        return max();
+    }
+
+    // Number of samples in the given bucket
+    uint64_t bucket(size_t i) const noexcept { return m_buckets[i].load(std::memory_order_relaxed); }
+
+    void reset() noexcept
+    {
+        for (auto& bucket : m_buckets)
+            bucket.store(0, std::memory_order_relaxed);
+        m_count.store(0, std::memory_order_relaxed);
+        m_total.store(0, std::memory_order_relaxed);
+        m_max.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> m_buckets[bucket_count] = {};
+    std::atomic<uint64_t> m_count = {0};
+    std::atomic<uint64_t> m_total = {0};
+    std::atomic<uint64_t> m_max = {0};
+
+    static size_t bucket_for(uint64_t value) noexcept
+    {
+        size_t bucket = 0;
+        while (value && bucket < bucket_count - 1) {
+            value >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+};
+} // namespace realm
+
+#endif /* REALM_LATENCY_HISTOGRAM_HPP */
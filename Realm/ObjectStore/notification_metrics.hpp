@@ -0,0 +1,51 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_NOTIFICATION_METRICS_HPP
+#define REALM_NOTIFICATION_METRICS_HPP
+
+#include "latency_histogram.hpp"
+
+namespace realm {
+// Histograms of how long each stage of delivering change notifications to a
+// Realm took, recorded if Realm::Config::record_notification_metrics is set.
+// One sample is recorded in each histogram every time notify() advances the
+// Realm's read transaction.
+struct NotificationMetrics {
+    // From a commit being made by another Realm instance to notify() starting
+    // to process it. When several commits are delivered together this is
+    // measured from the earliest of them.
+    LatencyHistogram queueing_delay;
+    // Advancing the read transaction, including parsing the transaction log
+    LatencyHistogram advance_duration;
+    // The binding context's callbacks and the Results notification callbacks
+    LatencyHistogram callback_duration;
+    // From the commit being made to notify() returning
+    LatencyHistogram total_latency;
+
+    void reset() noexcept
+    {
+        queueing_delay.reset();
+        advance_duration.reset();
+        callback_duration.reset();
+        total_latency.reset();
+    }
+};
+} // namespace realm
+
+#endif /* REALM_NOTIFICATION_METRICS_HPP */
@@ -18,21 +18,91 @@
 
 #include "results.hpp"
 
+#include "aggregate_workers.hpp"
+#include "results_notifier.hpp"
+#include "row_comparator.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
 #include <stdexcept>
 
 using namespace realm;
 
-#ifdef __has_cpp_attribute
-#define REALM_HAS_CCP_ATTRIBUTE(attr) __has_cpp_attribute(attr)
-#else
-#define REALM_HAS_CCP_ATTRIBUTE(attr) 0
-#endif
+namespace {
+// Aggregates over a vector of rows of a table, with the same interface as
+// Table's and TableView's so that Results::aggregate()'s getters can use it.
+// Null values are skipped, as they are by core.
+class RowVectorAggregates {
+public:
+    RowVectorAggregates(Table const& table, std::vector<size_t> const& rows) : m_table(table), m_rows(rows) { }
+
+    int64_t maximum_int(size_t col) const { return extreme(col, &Table::get_int, true); }
+    float maximum_float(size_t col) const { return extreme(col, &Table::get_float, true); }
+    double maximum_double(size_t col) const { return extreme(col, &Table::get_double, true); }
+    DateTime maximum_datetime(size_t col) const { return extreme(col, &Table::get_datetime, true); }
+
+    int64_t minimum_int(size_t col) const { return extreme(col, &Table::get_int, false); }
+    float minimum_float(size_t col) const { return extreme(col, &Table::get_float, false); }
+    double minimum_double(size_t col) const { return extreme(col, &Table::get_double, false); }
+    DateTime minimum_datetime(size_t col) const { return extreme(col, &Table::get_datetime, false); }
+
+    int64_t sum_int(size_t col) const { return sum<int64_t>(col, &Table::get_int); }
+    double sum_float(size_t col) const { return sum<double>(col, &Table::get_float); }
+    double sum_double(size_t col) const { return sum<double>(col, &Table::get_double); }
+
+    double average_int(size_t col) const { return average(col, &Table::get_int); }
+    double average_float(size_t col) const { return average(col, &Table::get_float); }
+    double average_double(size_t col) const { return average(col, &Table::get_double); }
+
+private:
+    Table const& m_table;
+    std::vector<size_t> const& m_rows;
 
-#if REALM_HAS_CCP_ATTRIBUTE(clang::fallthrough)
-#define REALM_FALLTHROUGH [[clang::fallthrough]]
-#else
-#define REALM_FALLTHROUGH
-#endif
+    template<typename T, typename Func>
+    void for_each(size_t col, T (Table::*get)(size_t, size_t) const, Func&& func) const
+    {
+        bool nullable = m_table.is_nullable(col);
+        for (auto row : m_rows) {
+            if (!nullable || !m_table.is_null(col, row)) {
+                func((m_table.*get)(col, row));
+            }
+        }
+    }
+
+    template<typename T>
+    T extreme(size_t col, T (Table::*get)(size_t, size_t) const, bool maximum) const
+    {
+        util::Optional<T> result;
+        for_each(col, get, [&](T value) {
+            if (!result || (maximum ? *result < value : value < *result)) {
+                result = value;
+            }
+        });
+        return result ? *result : T();
+    }
+
+    template<typename Sum, typename T>
+    Sum sum(size_t col, T (Table::*get)(size_t, size_t) const) const
+    {
+        Sum result = 0;
+        for_each(col, get, [&](T value) { result += value; });
+        return result;
+    }
+
+    template<typename T>
+    double average(size_t col, T (Table::*get)(size_t, size_t) const) const
+    {
+        double sum = 0;
+        size_t count = 0;
+        for_each(col, get, [&](T value) {
+            sum += value;
+            ++count;
+        });
+        return count ? sum / count : 0;
+    }
+};
+} // anonymous namespace
 
 Results::Results(SharedRealm r, Query q, SortOrder s)
 : m_realm(std::move(r))
@@ -65,13 +135,95 @@ void Results::validate_write() const
         throw InvalidTransactionException("Must be in a write transaction");
 }
 
+std::vector<size_t> const* Results::row_vector()
+{
+    if (is_windowed()) {
+        update_window();
+        return &m_window_rows;
+    }
+    // Changes made in the current write transaction aren't applied until
+    // it's committed
+    if (!m_incremental || m_realm->is_in_transaction()) {
+        return nullptr;
+    }
+    return m_incremental->rows();
+}
+
+void Results::update_window()
+{
+    if (m_window_view.is_attached() && m_window_view.is_in_sync()) {
+        return;
+    }
+    m_window_view = m_query.find_all(0, 0, 0);
+    m_window_rows.clear();
+
+    size_t end = m_limit > npos - m_offset ? npos : m_offset + m_limit;
+    if (end <= m_offset) {
+        // The window is empty
+        return;
+    }
+    auto copy_window = [&](TableView const& table_view) {
+        for (size_t i = m_offset; i < std::min(end, table_view.size()); ++i) {
+            m_window_rows.push_back(table_view.get_source_ndx(i));
+        }
+    };
+
+    if (!m_sort) {
+        // find_all() stops once it has found `end` matches
+        copy_window(m_query.find_all(0, npos, end));
+        return;
+    }
+    if (end >= m_table->size() || !_impl::RowComparator::can_compare(*m_table, m_sort)) {
+        // The heap would hold every match anyway, or can't order them
+        auto table_view = m_query.find_all();
+        table_view.sort(m_sort.columnIndices, m_sort.ascending);
+        copy_window(table_view);
+        return;
+    }
+
+    // Keep the first `end` rows in sort order in a max-heap, finding the
+    // matches a block of rows at a time so that neither every match nor
+    // every query evaluation has to be held at once
+    const size_t block_size = 4096;
+    _impl::RowComparator less(*m_table, m_sort);
+    std::vector<size_t> heap;
+    heap.reserve(end);
+    for (size_t begin = 0, size = m_table->size(); begin < size; begin += block_size) {
+        auto matches = m_query.find_all(begin, std::min(begin + block_size, size));
+        for (size_t i = 0; i < matches.size(); ++i) {
+            size_t row_ndx = matches.get_source_ndx(i);
+            if (heap.size() < end) {
+                heap.push_back(row_ndx);
+                std::push_heap(heap.begin(), heap.end(), less);
+            }
+            else if (less(row_ndx, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), less);
+                heap.back() = row_ndx;
+                std::push_heap(heap.begin(), heap.end(), less);
+            }
+        }
+    }
+    std::sort_heap(heap.begin(), heap.end(), less);
+    if (m_offset < heap.size()) {
+        m_window_rows.assign(heap.begin() + m_offset, heap.end());
+    }
+}
+
 size_t Results::size()
 {
     validate_read();
+    if (auto rows = row_vector()) {
+        return rows->size();
+    }
     switch (m_mode) {
         case Mode::Empty: return 0;
         case Mode::Table: return m_table->size();
-        case Mode::Query: return m_query.count();
+        case Mode::Query:
+            if (!m_count_view.is_attached() || !m_count_view.is_in_sync()) {
+                m_count_view = m_query.find_all(0, 0, 0);
+                m_cached_count = m_query.count();
+            }
+            return m_cached_count;
         case Mode::TableView:
             update_tableview();
             return m_table_view.size();
@@ -82,6 +234,11 @@ size_t Results::size()
 RowExpr Results::get(size_t row_ndx)
 {
     validate_read();
+    if (auto rows = row_vector()) {
+        if (row_ndx < rows->size())
+            return m_table->get((*rows)[row_ndx]);
+        throw OutOfBoundsIndexException{row_ndx, rows->size()};
+    }
     switch (m_mode) {
         case Mode::Empty: break;
         case Mode::Table:
@@ -102,6 +259,9 @@ RowExpr Results::get(size_t row_ndx)
 util::Optional<RowExpr> Results::first()
 {
     validate_read();
+    if (auto rows = row_vector()) {
+        return rows->empty() ? util::none : util::make_optional(m_table->get(rows->front()));
+    }
     switch (m_mode) {
         case Mode::Empty:
             return none;
@@ -118,6 +278,9 @@ util::Optional<RowExpr> Results::first()
 util::Optional<RowExpr> Results::last()
 {
     validate_read();
+    if (auto rows = row_vector()) {
+        return rows->empty() ? util::none : util::make_optional(m_table->get(rows->back()));
+    }
     switch (m_mode) {
         case Mode::Empty:
             return none;
@@ -168,22 +331,64 @@ size_t Results::index_of(Row const& row)
 size_t Results::index_of(size_t row_ndx)
 {
     validate_read();
+    if (auto rows = row_vector()) {
+        return rank_of(row_ndx, rows);
+    }
     switch (m_mode) {
         case Mode::Empty:
             return not_found;
         case Mode::Table:
             return row_ndx;
         case Mode::Query:
-            if (!m_sort)
-                return m_query.count(row_ndx, row_ndx + 1) ? m_query.count(0, row_ndx) : not_found;
-            REALM_FALLTHROUGH;
         case Mode::TableView:
             update_tableview();
-            return m_table_view.find_by_source_ndx(row_ndx);
+            return rank_of(row_ndx, nullptr);
     }
     REALM_UNREACHABLE();
 }
 
+size_t Results::rank_of(size_t row_ndx, std::vector<size_t> const* rows)
+{
+    // Incremental Results switch between their rows and the TableView when
+    // a write transaction begins or ends, which needn't change the table
+    bool from_rows = rows != nullptr;
+    if (!m_rank_view.is_attached() || !m_rank_view.is_in_sync() || m_rank_from_rows != from_rows) {
+        m_rank_view = m_query.find_all(0, 0, 0);
+        m_rank_from_rows = from_rows;
+
+        size_t size = rows ? rows->size() : m_table_view.size();
+        bool ascending = true;
+        m_rank.resize(size);
+        m_rank_positions.clear();
+        for (size_t i = 0; i < size; ++i) {
+            m_rank[i] = rows ? (*rows)[i] : m_table_view.get_source_ndx(i);
+            ascending = ascending && (i == 0 || m_rank[i - 1] < m_rank[i]);
+        }
+
+        if (!ascending) {
+            // Sorted rows and views of LinkViews aren't in table order, so
+            // the position of each row has to be stored too. The sort is
+            // stable so that the first of any duplicates is found.
+            m_rank_positions.resize(size);
+            std::iota(m_rank_positions.begin(), m_rank_positions.end(), 0);
+            std::stable_sort(m_rank_positions.begin(), m_rank_positions.end(),
+                             [&](size_t a, size_t b) { return m_rank[a] < m_rank[b]; });
+            std::vector<size_t> rank(size);
+            for (size_t i = 0; i < size; ++i) {
+                rank[i] = m_rank[m_rank_positions[i]];
+            }
+            m_rank = std::move(rank);
+        }
+    }
+
+    auto it = std::lower_bound(m_rank.begin(), m_rank.end(), row_ndx);
+    if (it == m_rank.end() || *it != row_ndx) {
+        return not_found;
+    }
+    size_t i = it - m_rank.begin();
+    return m_rank_positions.empty() ? i : m_rank_positions[i];
+}
+
 template<typename Int, typename Float, typename Double, typename DateTime>
 util::Optional<Mixed> Results::aggregate(size_t column, bool return_none_for_empty,
                                          Int agg_int, Float agg_float,
@@ -196,18 +401,42 @@ util::Optional<Mixed> Results::aggregate(size_t column, bool return_none_for_emp
         throw OutOfBoundsIndexException{column, m_table->get_column_count()};
 
     auto do_agg = [&](auto const& getter) -> util::Optional<Mixed> {
+        // Evaluate the getter over the given rows, or every row of the table
+        // if null, on the aggregate worker threads
+        auto in_parallel = [&](_impl::AggregateWorkers& workers, std::vector<size_t> const* rows) {
+            return util::Optional<Mixed>(getter(_impl::ParallelAggregates(workers, m_realm->read_transaction_version(),
+                                                                          *m_table, rows)));
+        };
+
+        if (auto rows = this->row_vector()) {
+            if (return_none_for_empty && rows->empty())
+                return none;
+            if (auto workers = this->parallel_aggregate_workers(rows->size()))
+                return in_parallel(*workers, rows);
+            return util::Optional<Mixed>(getter(RowVectorAggregates(*m_table, *rows)));
+        }
         switch (m_mode) {
             case Mode::Empty:
                 return none;
             case Mode::Table:
                 if (return_none_for_empty && m_table->size() == 0)
                     return none;
+                if (auto workers = this->parallel_aggregate_workers(m_table->size()))
+                    return in_parallel(*workers, nullptr);
                 return util::Optional<Mixed>(getter(*m_table));
             case Mode::Query:
             case Mode::TableView:
                 this->update_tableview();
                 if (return_none_for_empty && m_table_view.size() == 0)
                     return none;
+                if (auto workers = this->parallel_aggregate_workers(m_table_view.size())) {
+                    // The view's accessor can't be used from the worker
+                    // threads, so they're given its source row indices
+                    std::vector<size_t> rows(m_table_view.size());
+                    for (size_t i = 0; i < rows.size(); ++i)
+                        rows[i] = m_table_view.get_source_ndx(i);
+                    return in_parallel(*workers, &rows);
+                }
                 return util::Optional<Mixed>(getter(m_table_view));
         }
         REALM_UNREACHABLE();
@@ -224,6 +453,15 @@ util::Optional<Mixed> Results::aggregate(size_t column, bool return_none_for_emp
     }
 }
 
+_impl::AggregateWorkers* Results::parallel_aggregate_workers(size_t row_count) const
+{
+    // The workers read the version the write transaction began at, so can't
+    // see the changes made by it
+    if (!m_realm || row_count < 2 * _impl::ParallelAggregates::min_chunk_size || m_realm->is_in_transaction())
+        return nullptr;
+    return m_realm->aggregate_workers();
+}
+
 util::Optional<Mixed> Results::max(size_t column)
 {
     return aggregate(column, true,
@@ -262,6 +500,18 @@ util::Optional<Mixed> Results::average(size_t column)
 
 void Results::clear()
 {
+    if (is_windowed()) {
+        validate_write();
+        // Deleting from the end first leaves the indices of the rows still
+        // to be deleted unchanged by move_last_over()
+        update_window();
+        auto rows = m_window_rows;
+        std::sort(rows.begin(), rows.end(), std::greater<size_t>());
+        for (auto row_ndx : rows) {
+            m_table->move_last_over(row_ndx);
+        }
+        return;
+    }
     switch (m_mode) {
         case Mode::Empty:
             return;
@@ -297,6 +547,8 @@ Query Results::get_query() const
 TableView Results::get_tableview()
 {
     validate_read();
+    if (is_windowed())
+        throw UnsupportedWindowOperationException{};
     switch (m_mode) {
         case Mode::Empty:
             return {};
@@ -317,12 +569,72 @@ StringData Results::get_object_type() const noexcept
 
 Results Results::sort(realm::SortOrder&& sort) const
 {
-    return Results(m_realm, get_query(), std::move(sort));
+    Results results(m_realm, get_query(), std::move(sort));
+    results.m_offset = m_offset;
+    results.m_limit = m_limit;
+    return results;
 }
 
 Results Results::filter(Query&& q) const
 {
-    return Results(m_realm, get_query().and_query(std::move(q)), get_sort());
+    Results results(m_realm, get_query().and_query(std::move(q)), get_sort());
+    results.m_offset = m_offset;
+    results.m_limit = m_limit;
+    return results;
+}
+
+Results Results::limit(size_t count) const
+{
+    return slice(0, count);
+}
+
+Results Results::slice(size_t offset, size_t count) const
+{
+    if (m_mode == Mode::Empty) {
+        return *this;
+    }
+
+    Results results(m_realm, get_query(), get_sort());
+    results.m_offset = m_offset + offset;
+    // The new window can't extend past the end of this one
+    size_t available = m_limit == npos ? npos : m_limit - std::min(offset, m_limit);
+    results.m_limit = std::min(count, available);
+    return results;
+}
+
+NotificationToken Results::add_notification_callback(CollectionChangeCallback callback)
+{
+    validate_read();
+    if (is_windowed()) {
+        throw UnsupportedWindowOperationException{};
+    }
+    if (m_mode == Mode::Empty) {
+        // Rows can't be added to a table which doesn't exist without a
+        // schema change, which would invalidate the Results anyway
+        return {};
+    }
+
+    auto notifier = std::make_shared<_impl::ResultsNotifier>(m_realm, get_query(), m_sort, std::move(callback));
+    m_realm->register_results_notifier(notifier);
+    return {std::move(notifier)};
+}
+
+void Results::enable_incremental_updates()
+{
+    validate_read();
+    if (is_windowed()) {
+        throw UnsupportedWindowOperationException{};
+    }
+    if (m_incremental || (m_mode != Mode::Query && m_mode != Mode::TableView)) {
+        // Table-backed Results are already up to date for free
+        return;
+    }
+
+    auto notifier = std::make_shared<_impl::ResultsNotifier>(m_realm, get_query(), m_sort, nullptr, true);
+    m_realm->register_results_notifier(notifier);
+    m_incremental = std::shared_ptr<_impl::ResultsNotifier>(notifier.get(), [notifier](_impl::ResultsNotifier*) {
+        notifier->unregister();
+    });
 }
 
 Results::UnsupportedColumnTypeException::UnsupportedColumnTypeException(size_t column, const Table* table) {
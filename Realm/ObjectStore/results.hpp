@@ -19,6 +19,7 @@
 #ifndef REALM_RESULTS_HPP
 #define REALM_RESULTS_HPP
 
+#include "collection_notifications.hpp"
 #include "shared_realm.hpp"
 
 #include <realm/table_view.hpp>
@@ -69,7 +70,8 @@ public:
     StringData get_object_type() const noexcept;
 
     // Get the size of this results
-    // Can be either O(1) or O(N) depending on the state of things
+    // Can be either O(1) or O(N) depending on the state of things, with the
+    // count in Query mode cached until the table changes
     size_t size();
 
     // Get the row accessor for the given index
@@ -93,9 +95,22 @@ public:
     void clear();
 
     // Create a new Results by further filtering or sorting this Results
+    // The window of Results from limit() or slice() is applied after the new
+    // filter or sort order.
     Results filter(Query&& q) const;
     Results sort(SortOrder&& sort) const;
 
+    // Create a new Results containing at most `count` rows of this Results,
+    // starting from `offset`. Only as many rows as the window needs are
+    // found: unsorted queries stop once they have offset + count matches,
+    // and sorted ones keep the first offset + count in a bounded heap rather
+    // than sorting every match.
+    // get_tableview(), add_notification_callback() and
+    // enable_incremental_updates() throw UnsupportedWindowOperationException
+    // for the returned Results
+    Results limit(size_t count) const;
+    Results slice(size_t offset, size_t count) const;
+
     // Get the min/max/average/sum of the given column
     // All but sum() returns none when there are zero matching rows
     // sum() returns 0, except for when it returns none
@@ -106,6 +121,25 @@ public:
     util::Optional<Mixed> average(size_t column);
     util::Optional<Mixed> sum(size_t column);
 
+    // Register a callback which is called with the indices of the rows which
+    // were inserted, deleted, modified or moved each time a change to the
+    // Realm changes the rows in this Results. The changes are calculated from
+    // the transaction log and the previous rows in the Results, so observing
+    // a Results is much cheaper than diffing it in the binding. The callback
+    // is registered until the returned token is destroyed.
+    NotificationToken add_notification_callback(CollectionChangeCallback callback);
+
+    // Keep the rows in this Results (and copies of it) up to date by
+    // applying the row changes from the transaction log each time the Realm
+    // is advanced, rather than by re-running the query and sort whenever
+    // anything in the table changes. This makes advancing the Realm more
+    // expensive, as the transaction log then has to be parsed for row
+    // changes, so is only worthwhile for large Results which are read after
+    // most changes. size(), get(), first(), last() and index_of() use the
+    // maintained rows outside of write transactions. Must not be used for
+    // Results from a query restricted to a LinkView.
+    void enable_incremental_updates();
+
     enum class Mode {
         Empty, // Backed by nothing (for missing tables)
         Table, // Backed directly by a Table
@@ -135,6 +169,9 @@ public:
         StringData actual;
     };
 
+    // The operation is not supported for Results from limit() or slice()
+    struct UnsupportedWindowOperationException {};
+
     // The requested aggregate operation is not supported for the column type
     struct UnsupportedColumnTypeException {
         size_t column_index;
@@ -153,11 +190,54 @@ private:
 
     Mode m_mode = Mode::Empty;
 
+    // The result of counting the query in Query mode, which is valid for as
+    // long as m_count_view is in sync. The view is created with an empty
+    // range, so it holds no rows and just tracks the versions of the table
+    // and of anything else the query depends on.
+    size_t m_cached_count = 0;
+    TableView m_count_view;
+
+    // Set by enable_incremental_updates(). Shared by copies of the Results,
+    // and unregistered when the last of them is destroyed.
+    std::shared_ptr<_impl::ResultsNotifier> m_incremental;
+
+    // The window set by limit() or slice(), and the source row indices of the
+    // rows in it, which are valid while m_window_view is in sync (see
+    // m_count_view)
+    size_t m_offset = 0;
+    size_t m_limit = npos;
+    std::vector<size_t> m_window_rows;
+    TableView m_window_view;
+    bool is_windowed() const noexcept { return m_offset != 0 || m_limit != npos; }
+    void update_window();
+
+    // The source row indices of the rows in ascending order, and if the rows
+    // aren't in table order, the position of each of them, so that
+    // index_of() can binary search rather than scan the rows. Built from
+    // row_vector() if it's non-null and otherwise from m_table_view when
+    // index_of() is first called after the rows change, and valid while
+    // m_rank_view is in sync (see m_count_view).
+    std::vector<size_t> m_rank;
+    std::vector<size_t> m_rank_positions;
+    TableView m_rank_view;
+    bool m_rank_from_rows = false;
+    size_t rank_of(size_t row_ndx, std::vector<size_t> const* rows);
+
+    // The source row indices of the rows in the Results if they're held as a
+    // vector rather than by a TableView: the window for Results from limit()
+    // or slice(), or the rows kept up to date by m_incremental if they're
+    // current. Null otherwise.
+    std::vector<size_t> const* row_vector();
+
     void validate_read() const;
     void validate_write() const;
 
     void update_tableview();
 
+    // The threads to evaluate an aggregate over the given number of rows
+    // with, or null if it should be evaluated on this thread
+    _impl::AggregateWorkers* parallel_aggregate_workers(size_t row_count) const;
+
     template<typename Int, typename Float, typename Double, typename DateTime>
     util::Optional<Mixed> aggregate(size_t column, bool return_none_for_empty,
                                     Int agg_int, Float agg_float,
@@ -0,0 +1,163 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "scheduler.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdexcept>
+#include <system_error>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+using namespace realm;
+
+void Scheduler::set_notify_callback(std::function<void()> callback, std::weak_ptr<void> owner)
+{
+    if (m_callback && !m_callback_owner.expired()) {
+        throw std::logic_error("Scheduler is already in use by another Realm");
+    }
+    m_callback = std::move(callback);
+    m_callback_owner = std::move(owner);
+}
+
+void Scheduler::notify()
+{
+    // Only the first notification since the last delivery is timed, as that's
+    // the one which has been waiting the longest
+    LatencyHistogram::clock::rep expected = 0;
+    auto now = LatencyHistogram::clock::now().time_since_epoch().count();
+    m_notify_time.compare_exchange_strong(expected, now, std::memory_order_relaxed);
+
+    do_notify();
+}
+
+void Scheduler::deliver()
+{
+    auto notify_time = m_notify_time.exchange(0, std::memory_order_relaxed);
+    if (notify_time) {
+        LatencyHistogram::clock::duration since_epoch(notify_time);
+        m_delivery_latency.record_since(LatencyHistogram::clock::time_point(since_epoch));
+    }
+
+    if (m_callback) {
+        m_callback();
+    }
+}
+
+// On Linux an eventfd is used, while other platforms fall back to the two ends
+// of a non-blocking anonymous pipe
+EventLoopScheduler::EventLoopScheduler()
+{
+#ifdef __linux__
+    m_read_fd = m_write_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_read_fd == -1) {
+        throw std::system_error(errno, std::system_category());
+    }
+#else
+    int fds[2];
+    if (pipe(fds) == -1) {
+        throw std::system_error(errno, std::system_category());
+    }
+    m_read_fd = fds[0];
+    m_write_fd = fds[1];
+    for (int fd : fds) {
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+#endif
+}
+
+EventLoopScheduler::~EventLoopScheduler()
+{
+    close(m_read_fd);
+    if (m_write_fd != m_read_fd) {
+        close(m_write_fd);
+    }
+}
+
+void EventLoopScheduler::do_notify()
+{
+    // Both an eventfd and a full pipe return EAGAIN when there's too much
+    // unread data, in which case the fd is already readable and there's
+    // nothing more to do
+    uint64_t value = 1;
+#ifdef __linux__
+    ssize_t ret = write(m_write_fd, &value, sizeof value);
+#else
+    ssize_t ret = write(m_write_fd, &value, 1);
+#endif
+    static_cast<void>(ret);
+}
+
+void EventLoopScheduler::process()
+{
+    char buff[64];
+    while (read(m_read_fd, buff, sizeof buff) > 0) {
+        // An eventfd is drained by a single read, but a pipe may need several
+    }
+    deliver();
+}
+
+std::shared_ptr<ExecutorScheduler> ExecutorScheduler::make(Executor executor)
+{
+    return std::shared_ptr<ExecutorScheduler>(new ExecutorScheduler(std::move(executor)));
+}
+
+ExecutorScheduler::ExecutorScheduler(Executor executor)
+: m_executor(std::move(executor))
+{
+}
+
+void ExecutorScheduler::do_notify()
+{
+    // Don't queue up more than one pending delivery at a time, as a single
+    // call to the callback picks up all of the changes
+    if (m_queued.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    std::weak_ptr<ExecutorScheduler> weak_self = shared_from_this();
+    m_executor([weak_self] {
+        if (auto self = weak_self.lock()) {
+            self->m_queued.store(false, std::memory_order_release);
+            self->deliver();
+        }
+    });
+}
+
+bool PollingScheduler::poll()
+{
+    if (!m_pending.exchange(false, std::memory_order_acq_rel)) {
+        return false;
+    }
+    deliver();
+    return true;
+}
+
+#ifndef __APPLE__
+// Apple platforms use a CFRunLoop-based scheduler, defined in
+// impl/apple/run_loop_scheduler.cpp
+std::shared_ptr<Scheduler> Scheduler::make_default()
+{
+    return std::make_shared<EventLoopScheduler>();
+}
+#endif
@@ -0,0 +1,161 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_SCHEDULER_HPP
+#define REALM_SCHEDULER_HPP
+
+#include "latency_histogram.hpp"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace realm {
+// A Scheduler is how change notifications get from the thread which noticed
+// that a commit was made (typically a background listener thread) to the
+// thread which owns a Realm. Each Realm has its own Scheduler, which is either
+// supplied in the Realm's Config or created with make_default() for the
+// thread the Realm is opened on.
+//
+// notify() can be called from any thread, and results in the notify callback
+// being invoked on the scheduler's target thread at some later point. Multiple
+// calls to notify() before the callback is run may be coalesced into a single
+// invocation.
+class Scheduler {
+public:
+    virtual ~Scheduler() = default;
+
+    // Request that the notify callback be invoked on the target thread
+    void notify();
+
+    // Is the calling thread the one this scheduler delivers notifications on?
+    virtual bool is_on_thread() const noexcept = 0;
+
+    // Is this scheduler currently capable of delivering notifications? For
+    // example, a run loop scheduler for a thread which is not running its run
+    // loop will never invoke the callback.
+    virtual bool can_deliver() const noexcept = 0;
+
+    // Set the function to invoke on the target thread when notified. Must be
+    // called before the first call to notify(). A scheduler delivers
+    // notifications for a single owner (normally a Realm), so this throws
+    // std::logic_error if a callback was already set by an owner which is
+    // still alive.
+    void set_notify_callback(std::function<void()> callback, std::weak_ptr<void> owner);
+
+    // The time from the first call to notify() to the notify callback being
+    // invoked, for each delivery made by this scheduler
+    LatencyHistogram const& delivery_latency() const noexcept { return m_delivery_latency; }
+
+    // Create the appropriate scheduler for the current thread on the current
+    // platform: a run loop scheduler on Apple platforms and an
+    // EventLoopScheduler elsewhere
+    static std::shared_ptr<Scheduler> make_default();
+
+protected:
+    // Arrange for deliver() to be called on the target thread
+    virtual void do_notify() = 0;
+
+    // Invoke the notify callback. Must be called on the target thread.
+    void deliver();
+
+private:
+    std::function<void()> m_callback;
+    // The owner which set m_callback
+    std::weak_ptr<void> m_callback_owner;
+    LatencyHistogram m_delivery_latency;
+    // Time of the first notify() since the last delivery, or zero if there is
+    // no pending notification
+    std::atomic<LatencyHistogram::clock::rep> m_notify_time = {0};
+};
+
+// A scheduler which signals a file descriptor which can be waited on by an
+// external event loop (select(), poll(), epoll, libuv, etc.). When the fd
+// becomes readable, the thread which owns the Realm should call process(),
+// which invokes the notify callback.
+class EventLoopScheduler : public Scheduler {
+public:
+    EventLoopScheduler();
+    ~EventLoopScheduler();
+
+    // The fd to wait on for readability
+    int fd() const noexcept { return m_read_fd; }
+
+    // Reset the fd and deliver the pending notification, if any
+    void process();
+
+    bool is_on_thread() const noexcept override { return m_thread_id == std::this_thread::get_id(); }
+    bool can_deliver() const noexcept override { return true; }
+
+protected:
+    void do_notify() override;
+
+private:
+    std::thread::id m_thread_id = std::this_thread::get_id();
+    int m_read_fd = -1;
+    int m_write_fd = -1;
+};
+
+// A scheduler which hands delivery off to a user-supplied executor function,
+// such as one which posts work to an io loop. The executor must invoke the
+// function it is passed on the thread which created the scheduler.
+class ExecutorScheduler : public Scheduler, public std::enable_shared_from_this<ExecutorScheduler> {
+public:
+    using Executor = std::function<void(std::function<void()>)>;
+
+    // Deliveries hold a weak reference to the scheduler, so it can only be
+    // created as a shared_ptr
+    static std::shared_ptr<ExecutorScheduler> make(Executor executor);
+
+    bool is_on_thread() const noexcept override { return m_thread_id == std::this_thread::get_id(); }
+    bool can_deliver() const noexcept override { return true; }
+
+protected:
+    void do_notify() override;
+
+private:
+    ExecutorScheduler(Executor executor);
+
+    Executor m_executor;
+    std::thread::id m_thread_id = std::this_thread::get_id();
+    // Is there already a delivery queued on the executor?
+    std::atomic<bool> m_queued = {false};
+};
+
+// A scheduler which never wakes anything up and instead relies on the owning
+// thread periodically calling poll()
+class PollingScheduler : public Scheduler {
+public:
+    // Deliver the pending notification, if any. Returns whether there was one.
+    bool poll();
+
+    bool is_on_thread() const noexcept override { return m_thread_id == std::this_thread::get_id(); }
+    bool can_deliver() const noexcept override { return true; }
+
+protected:
+    void do_notify() override { m_pending.store(true, std::memory_order_release); }
+
+private:
+    std::thread::id m_thread_id = std::this_thread::get_id();
+    std::atomic<bool> m_pending = {false};
+};
+} // namespace realm
+
+#endif /* REALM_SCHEDULER_HPP */
@@ -19,13 +19,24 @@
 #include "shared_realm.hpp"
 
 #include "external_commit_helper.hpp"
+#include "aggregate_workers.hpp"
+#include "background_writer.hpp"
 #include "binding_context.hpp"
+#include "change_calculator.hpp"
+#include "commit_counter.hpp"
+#include "results_notifier.hpp"
+#include "scheduler.hpp"
 #include "schema.hpp"
 #include "transact_log_handler.hpp"
+#include "transaction_change_info.hpp"
+#include "write_gate.hpp"
 
 #include <realm/commit_log.hpp>
 #include <realm/group_shared.hpp>
 
+#include <algorithm>
+#include <future>
+#include <limits>
 #include <mutex>
 
 using namespace realm;
@@ -33,6 +44,22 @@ using namespace realm::_impl;
 
 RealmCache Realm::s_global_cache;
 
+namespace {
+// The WriteMetrics shared by every Realm instance for each path
+std::shared_ptr<WriteMetrics> write_metrics_for_path(std::string const& path)
+{
+    static std::mutex s_mutex;
+    static auto& s_metrics = *new std::map<std::string, std::shared_ptr<WriteMetrics>>;
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    auto& metrics = s_metrics[path];
+    if (!metrics) {
+        metrics = std::make_shared<WriteMetrics>();
+    }
+    return metrics;
+}
+} // anonymous namespace
+
 Realm::Config::Config(const Config& c)
 : path(c.path)
 , read_only(c.read_only)
@@ -42,6 +69,16 @@ Realm::Config::Config(const Config& c)
 , encryption_key(c.encryption_key)
 , schema_version(c.schema_version)
 , migration_function(c.migration_function)
+, min_notification_interval(c.min_notification_interval)
+, calculate_changes_in_background(c.calculate_changes_in_background)
+, record_notification_metrics(c.record_notification_metrics)
+, record_commit_stats(c.record_commit_stats)
+, group_commit(c.group_commit)
+, record_write_metrics(c.record_write_metrics)
+, advance_before_write_lock(c.advance_before_write_lock)
+, max_versions_per_step(c.max_versions_per_step)
+, aggregate_threads(c.aggregate_threads)
+, scheduler(c.scheduler)
 {
     if (c.schema) {
         schema = std::make_unique<Schema>(*c.schema);
@@ -74,6 +111,12 @@ Realm::Realm(Config config)
                                                                            SharedGroup::durability_Full;
             m_shared_group = std::make_unique<SharedGroup>(*m_history, durability, m_config.encryption_key.data(), !m_config.disable_format_upgrade);
         }
+        if (m_config.record_notification_metrics) {
+            m_notification_metrics = std::make_unique<NotificationMetrics>();
+        }
+        if (m_config.record_write_metrics && !m_config.read_only) {
+            m_write_metrics = write_metrics_for_path(m_config.path);
+        }
     }
     catch (util::File::PermissionDenied const& ex) {
         throw RealmFileException(RealmFileException::Kind::PermissionDenied, ex.get_path(),
@@ -143,8 +186,26 @@ SharedRealm Realm::get_shared_realm(Config config)
         }
     }
 
+    if (!config.scheduler) {
+        config.scheduler = Scheduler::make_default();
+    }
+
     SharedRealm realm(new Realm(std::move(config)));
 
+    WeakRealm weak_realm = realm;
+    realm->m_config.scheduler->set_notify_callback([weak_realm] {
+        if (auto realm = weak_realm.lock()) {
+            realm->notify();
+        }
+    }, realm);
+
+    if (realm->m_config.calculate_changes_in_background && !realm->m_config.read_only) {
+        auto scheduler = realm->m_config.scheduler;
+        realm->m_change_calculator = std::make_unique<ChangeCalculator>(realm->m_config, [scheduler] {
+            scheduler->notify();
+        });
+    }
+
     auto target_schema = std::move(realm->m_config.schema);
     auto target_schema_version = realm->m_config.schema_version;
     realm->m_config.schema_version = ObjectStore::get_schema_version(realm->read_group());
@@ -160,6 +221,7 @@ SharedRealm Realm::get_shared_realm(Config config)
         if (!realm->m_config.read_only) {
             realm->m_notifier = existing->m_notifier;
             realm->m_notifier->add_realm(realm.get());
+            realm->m_last_commit_version = realm->m_notifier->commit_version();
         }
     }
     else {
@@ -170,6 +232,10 @@ SharedRealm Realm::get_shared_realm(Config config)
         // otherwise get the schema from the group
         realm->m_config.schema = std::make_unique<Schema>(ObjectStore::schema_from_group(realm->read_group()));
 
+        if (realm->m_notifier) {
+            realm->m_last_commit_version = realm->m_notifier->commit_version();
+        }
+
         // if a target schema is supplied, verify that it matches or migrate to
         // it, as neeeded
         if (target_schema) {
@@ -207,8 +273,10 @@ void Realm::update_schema(std::unique_ptr<Schema> schema, uint64_t version)
     }
 
     read_group();
+    std::unique_lock<WriteGate> gate(write_gate());
     transaction::begin(*m_shared_group, *m_history, m_binding_context.get(),
                        /* error on schema changes */ false);
+    m_write_gate_lock = std::move(gate);
     m_in_transaction = true;
 
     struct WriteTransactionGuard {
@@ -291,8 +359,83 @@ void Realm::begin_transaction()
     // make sure we have a read transaction
     read_group();
 
-    transaction::begin(*m_shared_group, *m_history, m_binding_context.get());
+    if (m_notifier) {
+        m_last_commit_version = m_notifier->commit_version();
+    }
+
+    // Advance to the latest version before waiting for the write lock if
+    // asked to, so that other writers aren't blocked while the transaction
+    // logs are replayed. Only commits made after this then need to be
+    // replayed with the lock held.
+    bool advanced = m_config.advance_before_write_lock && m_shared_group->has_changed();
+    if (advanced) {
+        transaction::AdvanceTimings timings;
+        auto timings_ptr = m_write_metrics ? &timings : nullptr;
+        advance_checking_schema({}, [&](bool validate, SharedGroup::VersionID version) {
+            transaction::advance(*m_shared_group, *m_history, m_binding_context.get(),
+                                 change_info(), timings_ptr, validate, version);
+        });
+        if (m_write_metrics) {
+            m_write_metrics->advance_duration.record(timings.advance);
+            m_write_metrics->callback_duration.record(timings.callbacks);
+        }
+    }
+
+    auto lock_start = m_write_metrics ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+    begin_transaction_with_gate(std::unique_lock<WriteGate>(write_gate()), lock_start, advanced);
+}
+
+bool Realm::try_begin_transaction(std::chrono::milliseconds timeout)
+{
+    check_read_write(this);
+    verify_thread();
+
+    if (m_in_transaction) {
+        throw InvalidTransactionException("The Realm is already in a write transaction");
+    }
+
+    // Unlike begin_transaction(), nothing can be done before getting the
+    // write gate, as the read transaction has to be left alone on timeout
+    auto lock_start = m_write_metrics ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+    std::unique_lock<WriteGate> gate(write_gate(), std::defer_lock);
+    if (!gate.try_lock_for(timeout)) {
+        return false;
+    }
+
+    read_group();
+    if (m_notifier) {
+        m_last_commit_version = m_notifier->commit_version();
+    }
+    begin_transaction_with_gate(std::move(gate), lock_start);
+    return true;
+}
+
+WriteGate& Realm::write_gate()
+{
+    if (!m_write_gate) {
+        m_write_gate = WriteGate::get(m_config.path);
+    }
+    return *m_write_gate;
+}
+
+void Realm::begin_transaction_with_gate(std::unique_lock<WriteGate> gate,
+                                        std::chrono::steady_clock::time_point lock_start,
+                                        bool advanced)
+{
+    // Promoting to a write transaction always advances to the latest version,
+    // so unlike advance_checking_schema() it can't stop at the last version
+    // known not to need checking, and anything committed since the read
+    // transaction's version is always validated. If advance_before_write_lock
+    // is set, begin_transaction() has normally already advanced over most of
+    // it without the lock held.
+    transaction::begin(*m_shared_group, *m_history, m_binding_context.get(), true, change_info(), !advanced);
+    m_write_gate_lock = std::move(gate);
     m_in_transaction = true;
+
+    if (m_write_metrics) {
+        m_write_lock_acquired = std::chrono::steady_clock::now();
+        m_write_metrics->lock_wait.record(m_write_lock_acquired - lock_start);
+    }
 }
 
 void Realm::commit_transaction()
@@ -305,8 +448,47 @@ void Realm::commit_transaction()
     }
 
     m_in_transaction = false;
+    // Released once the commit is made, or if committing fails
+    auto gate = std::move(m_write_gate_lock);
+    auto commit_start = m_write_metrics ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+    size_t commit_size = m_write_metrics ? m_history->get_uncommitted_changes().size() : 0;
+
+    // The modified tables have to be published while the write lock is still
+    // held, so that they're visible to anyone who sees the new version.
+    // Whether the commit made schema changes which other Realms have to
+    // reject is recorded along with the version it began from, so that Realms
+    // which haven't reached it yet know whether they can skip validating the
+    // transaction logs
+    bool incompatible_schema_change = false;
+    std::unique_ptr<CommitStats> stats;
+    if (m_config.record_commit_stats) {
+        stats = std::make_unique<CommitStats>();
+    }
+    auto modified_tables = transaction::get_modified_tables(*m_history, change_info(),
+                                                            &incompatible_schema_change, stats.get());
+    auto version = m_notifier->will_commit(modified_tables, m_shared_group->get_version_of_current_transaction().version,
+                                           incompatible_schema_change);
     transaction::commit(*m_shared_group, *m_history, m_binding_context.get());
-    m_notifier->notify_others();
+    gate.unlock();
+    auto committed = m_shared_group->get_version_of_current_transaction();
+    m_notifier->record_snapshot(committed.version, committed.index);
+    if (m_write_metrics) {
+        auto now = std::chrono::steady_clock::now();
+        m_write_metrics->commit_duration.record(now - commit_start);
+        m_write_metrics->lock_held.record(now - m_write_lock_acquired);
+        m_write_metrics->transactions_committed.fetch_add(1, std::memory_order_relaxed);
+        m_write_metrics->bytes_committed.fetch_add(commit_size, std::memory_order_relaxed);
+    }
+    m_notifier->notify_others(version);
+
+    if (stats) {
+        stats->version = committed.version;
+        m_last_commit_stats = std::move(stats);
+        if (m_binding_context) {
+            m_binding_context->did_commit(*m_last_commit_stats);
+        }
+    }
+    deliver_results_notifications();
 }
 
 void Realm::cancel_transaction()
@@ -319,7 +501,137 @@ void Realm::cancel_transaction()
     }
 
     m_in_transaction = false;
+    auto gate = std::move(m_write_gate_lock);
     transaction::cancel(*m_shared_group, *m_history, m_binding_context.get());
+    gate.unlock();
+    if (m_write_metrics) {
+        m_write_metrics->lock_held.record_since(m_write_lock_acquired);
+        m_write_metrics->transactions_cancelled.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Deliver the changes from advancing to the latest version when the write
+    // transaction began
+    deliver_results_notifications();
+}
+
+void Realm::write(std::function<void(Realm&)> write)
+{
+    check_read_write(this);
+    verify_thread();
+
+    if (m_in_transaction) {
+        throw InvalidTransactionException("Can't call write() from within a write transaction");
+    }
+
+    if (!m_config.group_commit) {
+        begin_transaction();
+        try {
+            write(*this);
+        }
+        catch (...) {
+            cancel_transaction();
+            throw;
+        }
+        commit_transaction();
+        return;
+    }
+
+    if (!m_background_writer) {
+        m_background_writer = BackgroundWriter::get(m_config);
+    }
+    std::promise<void> done;
+    m_background_writer->enqueue(std::move(write), [&](std::exception_ptr error, SharedGroup::VersionID) {
+        if (error) {
+            done.set_exception(error);
+        }
+        else {
+            done.set_value();
+        }
+    });
+    done.get_future().get();
+    refresh();
+}
+
+void Realm::async_write(std::function<void(Realm&)> write, AsyncWriteCompletion completion)
+{
+    check_read_write(this);
+    verify_thread();
+
+    if (!m_background_writer) {
+        m_background_writer = BackgroundWriter::get(m_config);
+    }
+    if (!m_async_write_completions) {
+        m_async_write_completions = std::make_shared<AsyncWriteCompletions>();
+    }
+
+    // The writer thread only holds weak references to this Realm's state, as
+    // the Realm may be destroyed before the write completes
+    std::weak_ptr<AsyncWriteCompletions> weak_completions = m_async_write_completions;
+    std::weak_ptr<Scheduler> weak_scheduler = m_config.scheduler;
+    m_background_writer->enqueue(std::move(write), [=](std::exception_ptr error, SharedGroup::VersionID version) {
+        auto completions = weak_completions.lock();
+        auto scheduler = weak_scheduler.lock();
+        if (!completions || !scheduler) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(completions->mutex);
+            completions->ready.push_back({error ? 0 : version.version, [=] { completion(error, version); }});
+        }
+        scheduler->notify();
+    });
+}
+
+void Realm::deliver_async_write_completions()
+{
+    if (!m_async_write_completions) {
+        return;
+    }
+
+    // The Realm may not have reached the versions produced by the writes yet
+    // if it's advancing a step at a time, is waiting for changes to be
+    // calculated in the background or doesn't auto-refresh, in which case
+    // the completions wait for a later call. A Realm without a read
+    // transaction will see the latest version once it starts one.
+    auto current = m_group ? m_shared_group->get_version_of_current_transaction().version
+                           : std::numeric_limits<uint_fast64_t>::max();
+
+    std::vector<AsyncWriteCompletions::Ready> ready;
+    {
+        std::lock_guard<std::mutex> lock(m_async_write_completions->mutex);
+        auto& pending = m_async_write_completions->ready;
+        auto end = std::find_if(pending.begin(), pending.end(), [&](auto const& r) { return r.version > current; });
+        ready.assign(std::make_move_iterator(pending.begin()), std::make_move_iterator(end));
+        pending.erase(pending.begin(), end);
+    }
+    for (auto& r : ready) {
+        r.completion();
+    }
+}
+
+void Realm::schedule_async_write_completions()
+{
+    // Completions are only ever called from notify(), so when a manual
+    // refresh makes some of them deliverable the scheduler has to be asked
+    // to call it
+    if (!m_async_write_completions || !m_config.scheduler) {
+        return;
+    }
+    bool pending;
+    {
+        std::lock_guard<std::mutex> lock(m_async_write_completions->mutex);
+        pending = !m_async_write_completions->ready.empty();
+    }
+    if (pending) {
+        m_config.scheduler->notify();
+    }
+}
+
+SharedGroup::VersionID Realm::read_transaction_version()
+{
+    check_read_write(this);
+    verify_thread();
+    read_group();
+    return m_shared_group->get_version_of_current_transaction();
 }
 
 void Realm::invalidate()
@@ -336,6 +648,9 @@ void Realm::invalidate()
 
     m_shared_group->end_read();
     m_group = nullptr;
+    if (m_change_info) {
+        m_change_info->clear();
+    }
 }
 
 bool Realm::compact()
@@ -359,25 +674,310 @@ bool Realm::compact()
     return m_shared_group->compact();
 }
 
+template<typename Func>
+void Realm::advance_checking_schema(SharedGroup::VersionID target, Func&& advance)
+{
+    // Read-only Realms have no shared record of schema changes
+    if (!m_notifier) {
+        advance(true, target);
+        return;
+    }
+
+    // Only the versions up to `checked` are known not to need validating.
+    // Any commits after it may have been made since checking, or by a writer
+    // which doesn't record its schema changes, so advancing past it has to
+    // validate.
+    auto version = m_shared_group->get_version_of_current_transaction().version;
+    uint64_t checked = m_notifier->schema_checked_through(version);
+    if (target.version <= checked) {
+        advance(false, target);
+        return;
+    }
+
+    // Advancing to the latest version can still skip validation as far as
+    // the last recorded snapshot before `checked`, and then validate whatever
+    // is after it
+    uint64_t db_version;
+    uint32_t index;
+    if (target != SharedGroup::VersionID() || !m_notifier->find_snapshot(version, checked, db_version, index) ||
+        db_version > checked) {
+        advance(true, target);
+        return;
+    }
+    try {
+        advance(false, SharedGroup::VersionID(db_version, index));
+    }
+    catch (SharedGroup::BadVersion const&) {
+        // The recorded snapshot didn't match the one core has for the version
+        advance(true, target);
+        return;
+    }
+    if (m_shared_group->has_changed()) {
+        advance(true, target);
+    }
+}
+
 void Realm::notify()
 {
     verify_thread();
 
     if (m_shared_group->has_changed()) { // Throws
+        // Read the commit version before advancing so that any commits made
+        // while advancing are counted as unseen
+        uint64_t commit_version = m_notifier ? m_notifier->commit_version() : 0;
+        std::chrono::system_clock::time_point commit_time;
+        transaction::AdvanceTimings timings;
+        std::chrono::steady_clock::duration callbacks{0};
+        auto timed_callback = [&](auto&& fn) {
+            if (!m_notification_metrics) {
+                return fn();
+            }
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            callbacks += std::chrono::steady_clock::now() - start;
+        };
+
+        if (m_notification_metrics && m_notifier) {
+            commit_time = m_notifier->commit_time_after(m_last_commit_version);
+        }
+        auto old_version = m_shared_group->get_version_of_current_transaction();
+
         if (m_binding_context) {
-            m_binding_context->changes_available();
+            timed_callback([&] { m_binding_context->changes_available(); });
         }
         if (m_auto_refresh) {
             if (m_group) {
-                transaction::advance(*m_shared_group, *m_history, m_binding_context.get());
+                auto timings_ptr = m_notification_metrics ? &timings : nullptr;
+                // Results notifiers need the row changes from the transaction
+                // log, so there's nothing to gain from calculating the
+                // observed rows' changes in the background. Nor is there
+                // when stepping, which bounds how much of the log is parsed
+                // at once on this thread.
+                bool stepping = m_config.max_versions_per_step != 0;
+                if (stepping || !m_change_calculator || !m_results_notifiers.empty() || !advance_with_calculated_changes(timings_ptr)) {
+                    advance_checking_schema(next_step_version(), [&](bool validate, SharedGroup::VersionID target) {
+                        try {
+                            transaction::advance(*m_shared_group, *m_history, m_binding_context.get(),
+                                                 change_info(), timings_ptr, validate, target);
+                        }
+                        catch (SharedGroup::BadVersion const&) {
+                            // The recorded snapshot didn't match the one core
+                            // has for the version, so advance all the way,
+                            // which may be past what was checked for schema
+                            // changes
+                            transaction::advance(*m_shared_group, *m_history, m_binding_context.get(),
+                                                 change_info(), timings_ptr, true);
+                        }
+                    });
+                    timed_callback([&] { deliver_results_notifications(); });
+
+                    // Come back for the next step once the scheduler has had
+                    // a chance to run other work
+                    if (stepping && m_config.scheduler && m_shared_group->has_changed()) {
+                        m_config.scheduler->notify();
+                    }
+                }
             }
             else if (m_binding_context) {
                 m_binding_context->did_change({}, {});
             }
         }
+
+        if (m_group && old_version != m_shared_group->get_version_of_current_transaction()) {
+            m_last_commit_version = commit_version;
+            if (m_notification_metrics) {
+                record_notification_metrics(commit_time, timings, callbacks);
+            }
+        }
+    }
+
+    // The binding context may have started or stopped observing some types
+    if (m_group) {
+        update_observed_tables();
+    }
+
+    // With auto-refresh enabled, the Realm has now been advanced past any
+    // commits made by the writer thread before it notified the scheduler
+    deliver_async_write_completions();
+}
+
+void Realm::record_notification_metrics(std::chrono::system_clock::time_point commit_time,
+                                        transaction::AdvanceTimings const& timings,
+                                        std::chrono::steady_clock::duration callbacks)
+{
+    auto& metrics = *m_notification_metrics;
+    metrics.advance_duration.record(timings.advance);
+    metrics.callback_duration.record(timings.callbacks + callbacks);
+
+    // The commit time comes from the system clock as it's written by other
+    // processes, and so the delays are measured with it too
+    if (commit_time != std::chrono::system_clock::time_point()) {
+        auto now = std::chrono::system_clock::now();
+        auto processing = timings.advance + timings.callbacks + callbacks;
+        auto total = std::chrono::duration_cast<LatencyHistogram::clock::duration>(now - commit_time);
+        metrics.total_latency.record(total);
+        metrics.queueing_delay.record(total - processing);
     }
 }
 
+SharedGroup::VersionID Realm::next_step_version()
+{
+    if (!m_config.max_versions_per_step || !m_notifier) {
+        return {};
+    }
+    auto current = m_shared_group->get_version_of_current_transaction().version;
+    uint64_t db_version;
+    uint32_t index;
+    if (!m_notifier->find_snapshot(current, current + m_config.max_versions_per_step, db_version, index)) {
+        return {};
+    }
+    return SharedGroup::VersionID(db_version, index);
+}
+
+bool Realm::advance_with_calculated_changes(transaction::AdvanceTimings* timings)
+{
+    if (!m_binding_context) {
+        return false;
+    }
+    auto observers = m_binding_context->get_observed_rows();
+    if (observers.empty()) {
+        // There's no expensive change calculation to skip
+        return false;
+    }
+
+    auto version = m_shared_group->get_version_of_current_transaction();
+    ChangeCalculator::Changes changes;
+    if (!m_change_calculator->take(version, observers, changes)) {
+        // The scheduler will notify us again once the changes are ready
+        m_change_calculator->request(version, std::move(observers));
+        return true;
+    }
+    if (changes.error) {
+        // Redo the calculation on this thread so that the error is reported
+        // to the caller
+        return false;
+    }
+
+    transaction::advance(*m_shared_group, *m_history, m_binding_context.get(),
+                         changes.to, changes.observers, changes.invalidated, timings);
+
+    // More commits may have been made while the changes were being calculated
+    if (m_shared_group->has_changed()) {
+        observers = m_binding_context->get_observed_rows();
+        if (observers.empty()) {
+            advance_checking_schema({}, [&](bool validate, SharedGroup::VersionID version) {
+                transaction::advance(*m_shared_group, *m_history, m_binding_context.get(),
+                                     nullptr, nullptr, validate, version);
+            });
+        }
+        else {
+            m_change_calculator->request(changes.to, std::move(observers));
+        }
+    }
+    return true;
+}
+
+bool Realm::can_deliver_notifications() const noexcept
+{
+    return m_config.scheduler && m_config.scheduler->can_deliver();
+}
+
+void Realm::set_observed_object_types(std::vector<std::string> object_types)
+{
+    verify_thread();
+    m_observed_object_types = std::move(object_types);
+    read_group();
+    update_observed_tables();
+}
+
+void Realm::update_observed_tables()
+{
+    if (!m_notifier) {
+        return;
+    }
+
+    auto object_types = m_observed_object_types;
+    if (m_binding_context) {
+        auto context_types = m_binding_context->get_observed_object_types();
+        object_types.insert(object_types.end(), context_types.begin(), context_types.end());
+    }
+
+    uint64_t tables = object_types.empty() ? CommitCounter::all_tables : 0;
+    for (auto const& object_type : object_types) {
+        auto table = ObjectStore::table_for_object_type(m_group, object_type);
+        if (!table) {
+            // The table's index won't be known until it's created, which
+            // will wake up everyone as it's a schema change
+            tables = CommitCounter::all_tables;
+            break;
+        }
+        tables |= CommitCounter::table_bit(table->get_index_in_group());
+    }
+
+    if (tables != m_observed_tables) {
+        m_observed_tables = tables;
+        m_notifier->set_observed_tables(this, tables);
+    }
+}
+
+void Realm::register_results_notifier(std::shared_ptr<_impl::ResultsNotifier> notifier)
+{
+    verify_thread();
+    if (!m_change_info) {
+        m_change_info = std::make_unique<TransactionChangeInfo>();
+    }
+    if (!m_in_transaction) {
+        // Within a write transaction the current rows include uncommitted
+        // changes which the change info doesn't, so the baseline is recorded
+        // after the transaction is committed or cancelled instead
+        notifier->update_baseline();
+    }
+    m_results_notifiers.push_back(std::move(notifier));
+}
+
+void Realm::unregister_results_notifier(_impl::ResultsNotifier* notifier)
+{
+    auto it = std::find_if(m_results_notifiers.begin(), m_results_notifiers.end(),
+                           [=](auto const& ptr) { return ptr.get() == notifier; });
+    if (it != m_results_notifiers.end()) {
+        m_results_notifiers.erase(it);
+    }
+    if (m_results_notifiers.empty() && m_change_info) {
+        m_change_info->clear();
+    }
+}
+
+AggregateWorkers* Realm::aggregate_workers()
+{
+    if (m_config.aggregate_threads == 0 || m_config.read_only) {
+        return nullptr;
+    }
+    if (!m_aggregate_workers) {
+        m_aggregate_workers = AggregateWorkers::get(m_config);
+    }
+    return m_aggregate_workers.get();
+}
+
+TransactionChangeInfo* Realm::change_info() const
+{
+    return m_results_notifiers.empty() ? nullptr : m_change_info.get();
+}
+
+void Realm::deliver_results_notifications()
+{
+    if (m_results_notifiers.empty()) {
+        return;
+    }
+
+    // Callbacks can register and unregister notifiers and begin write
+    // transactions, so work with copies of the notifiers and change info
+    TransactionChangeInfo info;
+    std::swap(info, *m_change_info);
+    auto notifiers = m_results_notifiers;
+    for (auto& notifier : notifiers) {
+        notifier->deliver(info);
+    }
+}
 
 bool Realm::refresh()
 {
@@ -395,13 +995,53 @@ bool Realm::refresh()
     }
 
     if (m_group) {
-        transaction::advance(*m_shared_group, *m_history, m_binding_context.get());
+        if (m_notifier) {
+            m_last_commit_version = m_notifier->commit_version();
+        }
+        advance_checking_schema({}, [&](bool validate, SharedGroup::VersionID version) {
+            transaction::advance(*m_shared_group, *m_history, m_binding_context.get(),
+                                 change_info(), nullptr, validate, version);
+        });
+        deliver_results_notifications();
     }
     else {
         // Create the read transaction
         read_group();
     }
+    schedule_async_write_completions();
+
+    return true;
+}
+
+bool Realm::refresh_to(SharedGroup::VersionID version)
+{
+    verify_thread();
+    check_read_write(this);
+
+    if (m_in_transaction) {
+        throw InvalidTransactionException("Can't refresh to a version from within a write transaction");
+    }
+
+    try {
+        if (!m_group) {
+            // Create the read transaction at the requested version
+            m_group = &const_cast<Group&>(m_shared_group->begin_read(version));
+            return true;
+        }
+        if (version <= m_shared_group->get_version_of_current_transaction()) {
+            return false;
+        }
 
+        advance_checking_schema(version, [&](bool validate, SharedGroup::VersionID target) {
+            transaction::advance(*m_shared_group, *m_history, m_binding_context.get(),
+                                 change_info(), nullptr, validate, target);
+        });
+    }
+    catch (SharedGroup::BadVersion const&) {
+        throw InvalidTransactionException("The requested version is no longer available");
+    }
+    deliver_results_notifications();
+    schedule_async_write_completions();
     return true;
 }
 
@@ -427,6 +1067,14 @@ void Realm::close()
     m_history = nullptr;
     m_read_only_group = nullptr;
     m_notifier = nullptr;
+    m_change_calculator = nullptr;
+    m_aggregate_workers = nullptr;
+    // Waits for any writes this Realm queued to finish if this was the last
+    // reference to the writer
+    m_background_writer = nullptr;
+    m_write_gate = nullptr;
+    m_results_notifiers.clear();
+    m_change_info = nullptr;
     m_binding_context = nullptr;
 }
 
@@ -501,14 +1149,23 @@ void RealmCache::cache_realm(SharedRealm &realm, std::thread::id thread_id)
 
 void RealmCache::clear()
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    for (auto const& path : m_cache) {
-        for (auto const& thread : path.second) {
-            if (auto realm = thread.second.lock()) {
-                realm->close();
+    std::vector<SharedRealm> realms;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto const& path : m_cache) {
+            for (auto const& thread : path.second) {
+                if (auto realm = thread.second.lock()) {
+                    realms.push_back(std::move(realm));
+                }
             }
         }
+        m_cache.clear();
     }
 
-    m_cache.clear();
+    // Closing a Realm may wait for its background writer thread to exit,
+    // which may itself be waiting to look up a Realm in the cache, so the
+    // Realms are closed after releasing the lock
+    for (auto& realm : realms) {
+        realm->close();
+    }
 }
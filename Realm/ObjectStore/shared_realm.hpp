@@ -19,22 +19,41 @@
 #ifndef REALM_REALM_HPP
 #define REALM_REALM_HPP
 
+#include <chrono>
+#include <exception>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <vector>
 
+#include "commit_stats.hpp"
+#include "notification_metrics.hpp"
 #include "object_store.hpp"
+#include "write_metrics.hpp"
+
+#include <realm/group_shared.hpp>
 
 namespace realm {
     class ClientHistory;
     class Realm;
     class RealmCache;
     class BindingContext;
+    class Scheduler;
     typedef std::shared_ptr<Realm> SharedRealm;
     typedef std::weak_ptr<Realm> WeakRealm;
 
     namespace _impl {
+        class AggregateWorkers;
+        class BackgroundWriter;
+        class ChangeCalculator;
         class ExternalCommitHelper;
+        class ResultsNotifier;
+        class TransactionChangeInfo;
+        class WriteGate;
+        namespace transaction {
+            struct AdvanceTimings;
+        }
     }
 
     class Realm : public std::enable_shared_from_this<Realm>
@@ -56,6 +75,78 @@ namespace realm {
 
             MigrationFunction migration_function;
 
+            // The minimum time between notifications of commits made by other
+            // Realm instances. Commits made in the meantime are delivered in a
+            // single notification once the interval has passed, trading some
+            // staleness for not advancing the read transaction for every
+            // commit when another thread or process is making many small
+            // commits.
+            std::chrono::milliseconds min_notification_interval{0};
+
+            // If set, the changes to the rows observed by the binding context
+            // are calculated on a background thread, and the Realm is only
+            // advanced to the new version once they're ready rather than
+            // parsing the transaction log on the Realm's thread.
+            bool calculate_changes_in_background = false;
+
+            // If set, the time taken by each stage of delivering change
+            // notifications to the Realm is recorded, and can be read with
+            // notification_metrics().
+            bool record_notification_metrics = false;
+
+            // If set, statistics about what each write transaction did are
+            // gathered when it's committed, and can be read with
+            // last_commit_stats() and BindingContext::did_commit().
+            bool record_commit_stats = false;
+
+            // If set, write() runs the writes on a background thread shared
+            // by all of the Realm instances for the file in this process,
+            // which commits all of the writes queued at the same time in a
+            // single write transaction.
+            bool group_commit = false;
+
+            // If set, the time spent waiting for and holding the write lock
+            // and the amount of data committed is recorded, and can be read
+            // with write_metrics().
+            bool record_write_metrics = false;
+
+            // If set, begin_transaction() advances the read transaction to
+            // the latest version before waiting for the write lock, so that
+            // other writers aren't blocked while the transaction logs are
+            // replayed. The binding context is then notified of the changes
+            // before the write transaction begins rather than inside it.
+            bool advance_before_write_lock = false;
+
+            // If non-zero, notify() advances the read transaction by at most
+            // this many versions at a time when auto-refresh is enabled, and
+            // then asks the scheduler to notify the Realm again if there are
+            // more, so that a Realm which has fallen far behind the latest
+            // version replays the commits in smaller steps with other work
+            // interleaved between them. Stepping relies on the commits having
+            // been made by Realm instances which record their versions, and
+            // steps further if they weren't. refresh() always advances to the
+            // latest version.
+            uint64_t max_versions_per_step = 0;
+
+            // If non-zero, Results::min(), max(), sum() and average() over
+            // many rows split the rows into chunks which are evaluated in
+            // parallel by this many background threads and the calling
+            // thread, each reading the same version of the Realm, and then
+            // combine the results. The threads are shared by all of the Realm
+            // instances for the file in this process, and are only used
+            // outside of write transactions. Sums of float and double
+            // columns may differ in the last bits from the ones calculated
+            // on a single thread, as the values are added in a different
+            // order.
+            size_t aggregate_threads = 0;
+
+            // The scheduler used to deliver change notifications to the Realm.
+            // If null, Scheduler::make_default() is used to create one for the
+            // thread the Realm is opened on. Must not be shared between Realm
+            // instances: opening a Realm with a scheduler which is in use by
+            // another Realm which is still alive throws std::logic_error.
+            std::shared_ptr<Scheduler> scheduler;
+
             Config();
             Config(Config&&);
             Config(const Config& c);
@@ -85,15 +176,81 @@ namespace realm {
         const Config &config() const { return m_config; }
 
         void begin_transaction();
+        // Begin a write transaction if the write lock can be acquired within
+        // `timeout`. Returns false without advancing the read transaction or
+        // sending any notifications if it couldn't be.
+        bool try_begin_transaction(std::chrono::milliseconds timeout);
         void commit_transaction();
         void cancel_transaction();
         bool is_in_transaction() const { return m_in_transaction; }
 
+        // Run `write` in a write transaction and commit it, then refresh the
+        // Realm so that the changes are visible. Any exception thrown by
+        // `write` is rethrown after rolling back its changes.
+        //
+        // If the config has group_commit set, `write` is instead called on
+        // the background writer thread with that thread's Realm instance, and
+        // this blocks until a commit which includes it is durable. It must
+        // not use objects belonging to this Realm, and may be called more
+        // than once if another write in the same transaction throws.
+        void write(std::function<void(Realm&)> write);
+
+        // The version of the Realm's read transaction, which after committing
+        // a write transaction is the version it produced
+        SharedGroup::VersionID read_transaction_version();
+
+        // Run `write` on the background writer thread as write() does when
+        // group_commit is set, but without waiting for it or for the write
+        // lock. `completion` is then called on this Realm's thread by its
+        // scheduler once the Realm has advanced to the version produced by
+        // the commit which included the write (by auto-refreshing, or by
+        // refresh() if auto-refresh is disabled), with that version or with
+        // the exception thrown by the write or the commit. Completions are
+        // called in commit order, and aren't called if the Realm is destroyed
+        // first.
+        using AsyncWriteCompletion = std::function<void(std::exception_ptr error, SharedGroup::VersionID version)>;
+        void async_write(std::function<void(Realm&)> write, AsyncWriteCompletion completion);
+
         bool refresh();
+        // Advance the read transaction to the given version rather than the
+        // latest one, with the same notifications as refresh(). Returns false
+        // if the Realm is already at or past the version. Throws
+        // InvalidTransactionException if there's no snapshot of the version
+        // to advance to, as core discards versions which are no longer needed
+        // by any reader other than the latest; versions after the one the
+        // Realm is currently reading are kept until it advances.
+        bool refresh_to(SharedGroup::VersionID version);
         void set_auto_refresh(bool auto_refresh) { m_auto_refresh = auto_refresh; }
         bool auto_refresh() const { return m_auto_refresh; }
         void notify();
 
+        // Can notifications currently be delivered to this Realm by its
+        // scheduler?
+        bool can_deliver_notifications() const noexcept;
+
+        // Only wake this Realm up for commits made by other Realm instances
+        // which modify objects of the given types (or of the types returned
+        // by the binding context's get_observed_object_types()). If no types
+        // are given by either, the Realm is woken up for every commit. Realms
+        // which aren't woken up for a commit still see it the next time they
+        // are refreshed.
+        void set_observed_object_types(std::vector<std::string> object_types);
+
+        // Histograms of how long it took for commits made by other Realm
+        // instances to be delivered to this Realm, or null if the Realm's
+        // config doesn't have record_notification_metrics set
+        NotificationMetrics const* notification_metrics() const noexcept { return m_notification_metrics.get(); }
+
+        // Statistics about the last write transaction committed by this Realm,
+        // or null if none have been committed or the Realm's config doesn't
+        // have record_commit_stats set
+        CommitStats const* last_commit_stats() const noexcept { return m_last_commit_stats.get(); }
+
+        // Write lock metrics for the Realm's file, shared with the other
+        // Realm instances for it in this process, or null if the Realm's
+        // config doesn't have record_write_metrics set
+        WriteMetrics const* write_metrics() const noexcept { return m_write_metrics.get(); }
+
         void invalidate();
         bool compact();
 
@@ -101,6 +258,17 @@ namespace realm {
         void verify_thread() const;
         void verify_in_write() const;
 
+        // Run the given notifier each time the read transaction is advanced or
+        // a write transaction is committed, until it's unregistered. Used by
+        // Results::add_notification_callback().
+        void register_results_notifier(std::shared_ptr<_impl::ResultsNotifier> notifier);
+        void unregister_results_notifier(_impl::ResultsNotifier* notifier);
+
+        // The threads used to evaluate aggregates in parallel, or null if the
+        // config doesn't have aggregate_threads set or the Realm is read-only.
+        // Used by Results.
+        _impl::AggregateWorkers* aggregate_workers();
+
         // Close this Realm and remove it from the cache. Continuing to use a
         // Realm after closing it will produce undefined behavior.
         void close();
@@ -122,6 +290,97 @@ namespace realm {
         Group *m_group = nullptr;
 
         std::shared_ptr<_impl::ExternalCommitHelper> m_notifier;
+        std::unique_ptr<_impl::ChangeCalculator> m_change_calculator;
+        // Created the first time write() is called if group_commit is set or
+        // async_write() is called
+        std::shared_ptr<_impl::BackgroundWriter> m_background_writer;
+        // Created the first time aggregate_workers() is called
+        std::shared_ptr<_impl::AggregateWorkers> m_aggregate_workers;
+
+        // The completions of async_write() calls whose writes are done, added
+        // on the writer thread in commit order and called on this Realm's
+        // thread by notify() once the Realm's read transaction has reached
+        // the version which the write produced
+        struct AsyncWriteCompletions {
+            struct Ready {
+                // The version produced by the commit, or 0 if it failed
+                uint_fast64_t version;
+                std::function<void()> completion;
+            };
+            std::mutex mutex;
+            std::vector<Ready> ready;
+        };
+        std::shared_ptr<AsyncWriteCompletions> m_async_write_completions;
+        void deliver_async_write_completions();
+        void schedule_async_write_completions();
+
+        // Object types passed to set_observed_object_types()
+        std::vector<std::string> m_observed_object_types;
+        // The bitmask of tables last reported to m_notifier, which starts out
+        // as all tables
+        uint64_t m_observed_tables = ~uint64_t(0);
+
+        // Notifiers for Results with change callbacks, and the row changes
+        // made since they were last run
+        std::vector<std::shared_ptr<_impl::ResultsNotifier>> m_results_notifiers;
+        std::unique_ptr<_impl::TransactionChangeInfo> m_change_info;
+
+        // Get the change info to track row changes in, or nullptr if no one
+        // needs them
+        _impl::TransactionChangeInfo* change_info() const;
+        void deliver_results_notifications();
+
+        void update_observed_tables();
+
+        std::unique_ptr<NotificationMetrics> m_notification_metrics;
+        // The commit version as of the last time the read transaction was
+        // advanced, for finding the first commit not yet seen by this Realm
+        uint64_t m_last_commit_version = 0;
+
+        std::unique_ptr<CommitStats> m_last_commit_stats;
+
+        std::shared_ptr<WriteMetrics> m_write_metrics;
+        // When the current write transaction got the write lock, if metrics
+        // are being recorded
+        std::chrono::steady_clock::time_point m_write_lock_acquired;
+
+        // The advisory lock taken before the write lock, shared with the other
+        // Realm instances for the file and held for the duration of each
+        // write transaction. Obtained the first time a write is begun.
+        std::shared_ptr<_impl::WriteGate> m_write_gate;
+        std::unique_lock<_impl::WriteGate> m_write_gate_lock;
+        _impl::WriteGate& write_gate();
+        // Begin the write transaction once the gate is held. If the read
+        // transaction was just advanced, the binding context is only
+        // notified again if there's something new, so that it doesn't get two
+        // rounds of notifications for one write.
+        void begin_transaction_with_gate(std::unique_lock<_impl::WriteGate> gate,
+                                         std::chrono::steady_clock::time_point lock_start,
+                                         bool advanced = false);
+
+        // Advance the read transaction using changes calculated by
+        // m_change_calculator, or request that they be calculated if they
+        // aren't ready yet. Returns false if the changes need to be
+        // calculated on this thread instead.
+        bool advance_with_calculated_changes(_impl::transaction::AdvanceTimings* timings);
+
+        // The version for notify() to advance to when max_versions_per_step is
+        // set, or the default VersionID to advance to the latest version
+        SharedGroup::VersionID next_step_version();
+
+        // Call `advance(validate_schema_changes, version)` to advance the read
+        // transaction towards `target` (or the latest version if it's the
+        // default VersionID), only asking for the transaction logs to be
+        // checked for unsupported schema changes when the commits being
+        // advanced over aren't all known not to have made any. May call
+        // `advance` twice, first without validating as far as is known to be
+        // safe and then validating the rest of the way.
+        template<typename Func>
+        void advance_checking_schema(SharedGroup::VersionID target, Func&& advance);
+
+        void record_notification_metrics(std::chrono::system_clock::time_point commit_time,
+                                         _impl::transaction::AdvanceTimings const& timings,
+                                         std::chrono::steady_clock::duration callbacks);
 
       public:
         std::unique_ptr<BindingContext> m_binding_context;
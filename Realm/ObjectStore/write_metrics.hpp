@@ -0,0 +1,70 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_WRITE_METRICS_HPP
+#define REALM_WRITE_METRICS_HPP
+
+#include "latency_histogram.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+namespace realm {
+// Histograms and counters of how long write transactions spend waiting for and
+// holding the write lock, recorded if Realm::Config::record_write_metrics is
+// set. A single WriteMetrics is shared by every Realm instance in the process
+// for the same file which has it set, and is kept until the process exits.
+struct WriteMetrics {
+    // Advancing the read transaction to the latest version before waiting
+    // for the write lock in begin_transaction(), excluding the binding
+    // context's callbacks. Only recorded if the config has
+    // advance_before_write_lock set.
+    LatencyHistogram advance_duration;
+    // The binding context's callbacks while advancing
+    LatencyHistogram callback_duration;
+    // Waiting for the write lock in begin_transaction(). This also includes
+    // replaying the commits made since the read transaction's version, which
+    // with advance_before_write_lock set is only those made between
+    // advancing and getting the lock.
+    LatencyHistogram lock_wait;
+    // From getting the write lock to the end of commit_transaction() or
+    // cancel_transaction(), which is how long other writers are blocked for
+    LatencyHistogram lock_held;
+    // commit_transaction(), including writing the commit to disk
+    LatencyHistogram commit_duration;
+
+    std::atomic<uint64_t> transactions_committed = {0};
+    std::atomic<uint64_t> transactions_cancelled = {0};
+    // The total size of the transaction logs of the committed transactions
+    std::atomic<uint64_t> bytes_committed = {0};
+
+    void reset() noexcept
+    {
+        advance_duration.reset();
+        callback_duration.reset();
+        lock_wait.reset();
+        lock_held.reset();
+        commit_duration.reset();
+        transactions_committed.store(0, std::memory_order_relaxed);
+        transactions_cancelled.store(0, std::memory_order_relaxed);
+        bytes_committed.store(0, std::memory_order_relaxed);
+    }
+};
+} // namespace realm
+
+#endif /* REALM_WRITE_METRICS_HPP */
@@ -0,0 +1,277 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#import <XCTest/XCTest.h>
+
+#import "index_set.hpp"
+
+#import <algorithm>
+#import <random>
+#import <vector>
+
+#if !DEBUG && TARGET_OS_IPHONE && !TARGET_IPHONE_SIMULATOR
+
+namespace {
+// The previous single-vector implementation of IndexSet, kept as a baseline
+// for comparison
+class VectorIndexSet {
+public:
+    void add(size_t index)
+    {
+        do_add(find(index), index);
+    }
+
+    void insert_at(size_t index)
+    {
+        auto pos = find(index);
+        if (pos != m_ranges.end()) {
+            if (pos->first >= index)
+                ++pos->first;
+            ++pos->second;
+            for (auto it = pos + 1; it != m_ranges.end(); ++it) {
+                ++it->first;
+                ++it->second;
+            }
+        }
+        do_add(pos, index);
+    }
+
+    void add_shifted(size_t index)
+    {
+        auto it = m_ranges.begin();
+        for (auto end = m_ranges.end(); it != end && it->first <= index; ++it) {
+            index += it->second - it->first;
+        }
+        do_add(it, index);
+    }
+
+private:
+    using iterator = std::vector<std::pair<size_t, size_t>>::iterator;
+    std::vector<std::pair<size_t, size_t>> m_ranges;
+
+    iterator find(size_t index)
+    {
+        for (auto it = m_ranges.begin(), end = m_ranges.end(); it != end; ++it) {
+            if (it->second > index)
+                return it;
+        }
+        return m_ranges.end();
+    }
+
+    void do_add(iterator it, size_t index)
+    {
+        bool more_before = it != m_ranges.begin(), valid = it != m_ranges.end();
+        if (valid && it->first <= index && it->second > index) {
+        }
+        else if (more_before && (it - 1)->second == index) {
+            ++(it - 1)->second;
+            if (valid && (it - 1)->second == it->first) {
+                (it - 1)->second = it->second;
+                m_ranges.erase(it);
+            }
+        }
+        else if (valid && it->first == index + 1) {
+            --it->first;
+        }
+        else {
+            m_ranges.insert(it, {index, index + 1});
+        }
+    }
+};
+
+// Every other index in a random order, so that none of them are adjacent
+std::vector<size_t> sparse_indices(size_t count)
+{
+    std::vector<size_t> indices(count);
+    for (size_t i = 0; i < count; ++i) {
+        indices[i] = i * 2;
+    }
+    std::shuffle(indices.begin(), indices.end(), std::mt19937(0));
+    return indices;
+}
+
+template<typename Set>
+void add_sparse(std::vector<size_t> const& indices)
+{
+    Set set;
+    for (auto index : indices) {
+        set.add(index);
+    }
+}
+
+template<typename Set>
+void insert_sparse(std::vector<size_t> const& indices)
+{
+    // Inserting at random positions in a LinkList
+    Set set;
+    for (size_t i = 0; i < indices.size(); ++i) {
+        set.insert_at(indices[i] / 2 % (i + 1));
+    }
+}
+
+template<typename Set>
+void remove_forward(size_t count)
+{
+    // Removing every tenth object from a LinkList, from front to back
+    Set set;
+    for (size_t i = 0; i < count; ++i) {
+        set.add_shifted(i * 10);
+    }
+}
+
+// Every `step`th index from zero, added in order
+realm::IndexSet every_nth_index(size_t count, size_t step)
+{
+    realm::IndexSet set;
+    for (size_t i = 0; i < count; ++i) {
+        set.add(i * step);
+    }
+    return set;
+}
+
+size_t count_by_iterating(realm::IndexSet const& set)
+{
+    // Iterating over the ranges as done when converting to an NSIndexSet
+    size_t count = 0;
+    for (auto range : set) {
+        count += range.second - range.first;
+    }
+    return count;
+}
+} // anonymous namespace
+
+@interface IndexSetPerformanceTests : XCTestCase
+@end
+
+@implementation IndexSetPerformanceTests
+
+- (void)testAddSparseVector1000 {
+    auto indices = sparse_indices(1000);
+    [self measureBlock:^{ add_sparse<VectorIndexSet>(indices); }];
+}
+
+- (void)testAddSparseVector10000 {
+    auto indices = sparse_indices(10000);
+    [self measureBlock:^{ add_sparse<VectorIndexSet>(indices); }];
+}
+
+- (void)testAddSparse1000 {
+    auto indices = sparse_indices(1000);
+    [self measureBlock:^{ add_sparse<realm::IndexSet>(indices); }];
+}
+
+- (void)testAddSparse10000 {
+    auto indices = sparse_indices(10000);
+    [self measureBlock:^{ add_sparse<realm::IndexSet>(indices); }];
+}
+
+- (void)testAddSparse100000 {
+    auto indices = sparse_indices(100000);
+    [self measureBlock:^{ add_sparse<realm::IndexSet>(indices); }];
+}
+
+- (void)testAddSparse1000000 {
+    auto indices = sparse_indices(1000000);
+    [self measureBlock:^{ add_sparse<realm::IndexSet>(indices); }];
+}
+
+- (void)testInsertSparseVector1000 {
+    auto indices = sparse_indices(1000);
+    [self measureBlock:^{ insert_sparse<VectorIndexSet>(indices); }];
+}
+
+- (void)testInsertSparseVector10000 {
+    auto indices = sparse_indices(10000);
+    [self measureBlock:^{ insert_sparse<VectorIndexSet>(indices); }];
+}
+
+- (void)testInsertSparse1000 {
+    auto indices = sparse_indices(1000);
+    [self measureBlock:^{ insert_sparse<realm::IndexSet>(indices); }];
+}
+
+- (void)testInsertSparse10000 {
+    auto indices = sparse_indices(10000);
+    [self measureBlock:^{ insert_sparse<realm::IndexSet>(indices); }];
+}
+
+- (void)testInsertSparse100000 {
+    auto indices = sparse_indices(100000);
+    [self measureBlock:^{ insert_sparse<realm::IndexSet>(indices); }];
+}
+
+- (void)testInsertSparse1000000 {
+    auto indices = sparse_indices(1000000);
+    [self measureBlock:^{ insert_sparse<realm::IndexSet>(indices); }];
+}
+
+- (void)testRemoveForwardVector1000 {
+    [self measureBlock:^{ remove_forward<VectorIndexSet>(1000); }];
+}
+
+- (void)testRemoveForwardVector10000 {
+    [self measureBlock:^{ remove_forward<VectorIndexSet>(10000); }];
+}
+
+- (void)testRemoveForward1000 {
+    [self measureBlock:^{ remove_forward<realm::IndexSet>(1000); }];
+}
+
+- (void)testRemoveForward10000 {
+    [self measureBlock:^{ remove_forward<realm::IndexSet>(10000); }];
+}
+
+- (void)testRemoveForward100000 {
+    [self measureBlock:^{ remove_forward<realm::IndexSet>(100000); }];
+}
+
+- (void)testRemoveForward1000000 {
+    [self measureBlock:^{ remove_forward<realm::IndexSet>(1000000); }];
+}
+
+- (void)testIterateDense100000 {
+    auto set = every_nth_index(100000, 2);
+    [self measureBlock:^{ count_by_iterating(set); }];
+}
+
+- (void)testIterateDense1000000 {
+    auto set = every_nth_index(1000000, 2);
+    [self measureBlock:^{ count_by_iterating(set); }];
+}
+
+- (void)testUnionDense100000 {
+    auto evens = every_nth_index(100000, 2);
+    auto threes = every_nth_index(100000, 3);
+    [self measureBlock:^{
+        auto set = evens;
+        set.add(threes);
+    }];
+}
+
+- (void)testUnionDense1000000 {
+    auto evens = every_nth_index(1000000, 2);
+    auto threes = every_nth_index(1000000, 3);
+    [self measureBlock:^{
+        auto set = evens;
+        set.add(threes);
+    }];
+}
+
+@end
+
+#endif
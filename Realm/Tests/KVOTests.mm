@@ -1554,6 +1554,19 @@ public:
         AssertIndexChange(NSKeyValueChangeRemoval, ([NSIndexSet indexSetWithIndexesInRange:{0, 3}]));
     }
 
+    for (int i = 0; i < 6; ++i) {
+        [obj.arrayCol addObject:obj];
+    }
+    {
+        // removed indices which span more than one range before the clear
+        KVORecorder r(self, obj, @"arrayCol");
+        [obj.arrayCol removeObjectAtIndex:4];
+        [obj.arrayCol removeObjectAtIndex:1];
+        [obj.arrayCol removeObjectAtIndex:0];
+        [obj.arrayCol removeAllObjects];
+        AssertIndexChange(NSKeyValueChangeRemoval, ([NSIndexSet indexSetWithIndexesInRange:{0, 6}]));
+    }
+
     [obj.arrayCol addObject:obj];
     {
         KVORecorder r(self, obj, @"arrayCol");
@@ -0,0 +1,204 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#import "RLMTestCase.h"
+
+#import "object_schema.hpp"
+#import "object_store.hpp"
+#import "property.hpp"
+#import "scheduler.hpp"
+#import "schema.hpp"
+#import "shared_realm.hpp"
+
+#import <realm/table.hpp>
+
+#import <condition_variable>
+#import <mutex>
+#import <thread>
+#import <vector>
+
+#if !DEBUG && TARGET_OS_IPHONE && !TARGET_IPHONE_SIMULATOR
+
+namespace {
+std::string test_realm_path()
+{
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:@"notification-performance.realm"].UTF8String;
+}
+
+realm::SharedRealm open_realm(std::shared_ptr<realm::Scheduler> scheduler)
+{
+    realm::Property value;
+    value.name = "value";
+    value.type = realm::PropertyTypeInt;
+
+    realm::ObjectSchema object_schema;
+    object_schema.name = "IntObject";
+    object_schema.properties.push_back(value);
+
+    realm::Realm::Config config;
+    config.path = test_realm_path();
+    config.cache = false;
+    config.schema = std::make_unique<realm::Schema>(std::vector<realm::ObjectSchema>{object_schema});
+    config.schema_version = 0;
+    config.scheduler = std::move(scheduler);
+    return realm::Realm::get_shared_realm(std::move(config));
+}
+
+realm::TableRef table(realm::Realm& realm)
+{
+    return realm::ObjectStore::table_for_object_type(realm.read_group(), "IntObject");
+}
+
+// Queues up the deliveries for the schedulers it creates so that they can be
+// run on the thread which owns the Realms, without needing a run loop
+class DeliveryQueue {
+public:
+    std::shared_ptr<realm::Scheduler> make_scheduler()
+    {
+        return realm::ExecutorScheduler::make([this](std::function<void()> fn) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending.push_back(std::move(fn));
+            m_cv.notify_one();
+        });
+    }
+
+    // Wait for at least `count` deliveries to be queued and then run all of
+    // the queued deliveries, which calls Realm::notify() on each Realm
+    void deliver(size_t count)
+    {
+        std::vector<std::function<void()>> pending;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [&] { return m_pending.size() >= count; });
+            pending.swap(m_pending);
+        }
+        for (auto& fn : pending) {
+            fn();
+        }
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<std::function<void()>> m_pending;
+};
+
+// Make a series of commits with the given number of other Realm instances
+// open on the file, waiting after each commit for every one of them to be
+// notified and then advancing them to the new version
+void commit_and_notify(size_t listener_count, size_t commit_count)
+{
+    // The writer's own notifications are never delivered
+    auto writer = open_realm(std::make_shared<realm::PollingScheduler>());
+
+    DeliveryQueue queue;
+    std::vector<realm::SharedRealm> listeners;
+    for (size_t i = 0; i < listener_count; ++i) {
+        listeners.push_back(open_realm(queue.make_scheduler()));
+        listeners.back()->read_group();
+    }
+
+    for (size_t i = 0; i < commit_count; ++i) {
+        writer->begin_transaction();
+        auto t = table(*writer);
+        t->set_int(0, 0, t->get_int(0, 0) + 1);
+        writer->commit_transaction();
+
+        queue.deliver(listener_count);
+    }
+}
+
+// Take turns with another thread incrementing the value, with this thread
+// making the commits which leave it odd if `parity` is 0 and even if it's 1
+void increment_in_turn(int64_t parity, int64_t stop_value)
+{
+    DeliveryQueue queue;
+    auto realm = open_realm(queue.make_scheduler());
+    while (true) {
+        auto t = table(*realm);
+        int64_t value = t->get_int(0, 0);
+        if (value >= stop_value) {
+            return;
+        }
+        if (value % 2 == parity) {
+            realm->begin_transaction();
+            t->set_int(0, 0, value + 1);
+            realm->commit_transaction();
+        }
+        else {
+            // Wait for the other thread's commit
+            queue.deliver(1);
+        }
+    }
+}
+
+// The C++ equivalent of PerformanceTests' testCrossThreadSyncLatency
+void cross_thread_sync(int64_t stop_value)
+{
+    {
+        auto realm = open_realm(std::make_shared<realm::PollingScheduler>());
+        realm->begin_transaction();
+        table(*realm)->set_int(0, 0, 0);
+        realm->commit_transaction();
+    }
+
+    std::thread other([=] { increment_in_turn(1, stop_value); });
+    increment_in_turn(0, stop_value);
+    other.join();
+}
+} // anonymous namespace
+
+@interface NotificationPerformanceTests : XCTestCase
+@end
+
+@implementation NotificationPerformanceTests
+
+- (void)setUp {
+    [super setUp];
+    RLMDeleteRealmFilesAtPath(@(test_realm_path().c_str()));
+
+    auto realm = open_realm(nullptr);
+    realm->begin_transaction();
+    table(*realm)->add_empty_row();
+    realm->commit_transaction();
+}
+
+- (void)tearDown {
+    RLMDeleteRealmFilesAtPath(@(test_realm_path().c_str()));
+    [super tearDown];
+}
+
+- (void)testCommitNotificationLatencyWithOneListener {
+    [self measureBlock:^{ commit_and_notify(1, 100); }];
+}
+
+- (void)testCommitNotificationLatencyWithTenListeners {
+    [self measureBlock:^{ commit_and_notify(10, 100); }];
+}
+
+- (void)testCommitNotificationLatencyWithOneHundredListeners {
+    [self measureBlock:^{ commit_and_notify(100, 100); }];
+}
+
+- (void)testCrossThreadSyncLatency {
+    [self measureBlock:^{ cross_thread_sync(500); }];
+}
+
+@end
+
+#endif
@@ -0,0 +1,889 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#import "RLMTestCase.h"
+
+#import "binding_context.hpp"
+#import "change_stream.hpp"
+#import "object_schema.hpp"
+#import "object_store.hpp"
+#import "property.hpp"
+#import "scheduler.hpp"
+#import "schema.hpp"
+#import "shared_realm.hpp"
+
+#import <realm/commit_log.hpp>
+#import <realm/group_shared.hpp>
+#import <realm/table.hpp>
+
+#import <algorithm>
+#import <atomic>
+#import <fstream>
+#import <functional>
+#import <thread>
+#import <vector>
+
+namespace {
+realm::ObjectSchema object_schema(std::string name, realm::PropertyType type)
+{
+    realm::Property value;
+    value.name = "value";
+    value.type = type;
+
+    realm::ObjectSchema object_schema;
+    object_schema.name = std::move(name);
+    object_schema.properties.push_back(value);
+    return object_schema;
+}
+
+// A PrimaryKeyObject type with a string `id` primary key and an int `value`
+realm::ObjectSchema primary_key_object_schema()
+{
+    realm::Property id;
+    id.name = "id";
+    id.type = realm::PropertyTypeString;
+    id.is_primary = true;
+
+    auto schema = object_schema("PrimaryKeyObject", realm::PropertyTypeInt);
+    schema.properties.insert(schema.properties.begin(), id);
+    schema.primary_key = "id";
+    return schema;
+}
+
+// Open the test Realm, with IntObject and StringObject types which each have
+// a single `value` property, and PrimaryKeyObject
+realm::SharedRealm open_realm(std::function<void(realm::Realm::Config&)> configure = nullptr)
+{
+    realm::Realm::Config config;
+    config.path = RLMTestRealmPath().UTF8String;
+    config.cache = false;
+    config.schema = std::make_unique<realm::Schema>(std::vector<realm::ObjectSchema>{
+        object_schema("IntObject", realm::PropertyTypeInt),
+        object_schema("StringObject", realm::PropertyTypeString),
+        primary_key_object_schema(),
+    });
+    config.schema_version = 0;
+    if (configure) {
+        configure(config);
+    }
+    return realm::Realm::get_shared_realm(std::move(config));
+}
+
+realm::TableRef table(realm::Realm& realm, const char* object_type = "IntObject")
+{
+    return realm::ObjectStore::table_for_object_type(realm.read_group(), object_type);
+}
+
+void add_rows(realm::Realm& realm, size_t count, const char* object_type = "IntObject")
+{
+    realm.begin_transaction();
+    table(realm, object_type)->add_empty_row(count);
+    realm.commit_transaction();
+}
+
+// Add a column to IntObject's table by committing directly to the Realm file,
+// like a writer which doesn't record its schema changes in the commit counter
+void add_column_without_recording()
+{
+    auto history = realm::make_client_history(RLMTestRealmPath().UTF8String);
+    realm::SharedGroup sg(*history);
+    realm::WriteTransaction wt(sg);
+    wt.get_table("class_IntObject")->add_column(realm::type_Int, "extra");
+    wt.commit();
+}
+
+// Add a PrimaryKeyObject. Must be called within a write transaction.
+void add_object(realm::Realm& realm, const char* id, int64_t value)
+{
+    auto t = table(realm, "PrimaryKeyObject");
+    size_t row = t->add_empty_row();
+    t->set_string(0, row, id);
+    t->set_int(1, row, value);
+}
+
+// The value of the named property in an ObjectChange, or a null value if it
+// has none
+realm::ChangeValue change_value(realm::ObjectChange const& change, const char* name)
+{
+    for (auto const& value : change.values) {
+        if (value.name == name) {
+            return value.value;
+        }
+    }
+    realm::ChangeValue none;
+    none.null = true;
+    return none;
+}
+
+// The lines in a text file
+std::vector<std::string> read_lines(std::string const& path)
+{
+    std::vector<std::string> lines;
+    std::ifstream in(path);
+    for (std::string line; std::getline(in, line); ) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+// A scheduler which delivers notifications on the main thread, counting the
+// number of deliveries it's asked to make
+std::shared_ptr<realm::Scheduler> counting_scheduler(std::shared_ptr<std::atomic<int>> count)
+{
+    return realm::ExecutorScheduler::make([=](std::function<void()> fn) {
+        ++*count;
+        dispatch_async(dispatch_get_main_queue(), ^{ fn(); });
+    });
+}
+
+// Run the main run loop until `done` returns true, or until `timeout` seconds
+// have passed. Returns the final result of `done`.
+bool run_until(std::function<bool()> done, NSTimeInterval timeout = 5)
+{
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:timeout];
+    while (!done()) {
+        if ([deadline timeIntervalSinceNow] < 0) {
+            return false;
+        }
+        [NSRunLoop.currentRunLoop runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    return true;
+}
+
+// Wait for `scheduler` to be notified, and then deliver the notification.
+// Returns false if it wasn't notified within five seconds.
+bool deliver_next(realm::PollingScheduler& scheduler)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!scheduler.poll()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// Run the main run loop for `duration` seconds, to give notifications which
+// shouldn't be delivered a chance to be
+void run_for(NSTimeInterval duration)
+{
+    [NSRunLoop.currentRunLoop runUntilDate:[NSDate dateWithTimeIntervalSinceNow:duration]];
+}
+
+// A binding context which observes a single row of a table, so that the
+// changes to it are calculated when the Realm advances, and records the
+// changes delivered for it
+class RowObservingContext : public realm::BindingContext {
+public:
+    RowObservingContext(size_t table_ndx, size_t row_ndx = 0) : table_ndx(table_ndx), row_ndx(row_ndx) { }
+
+    std::vector<ObserverState> get_observed_rows() override
+    {
+        return {{table_ndx, row_ndx, nullptr, {}}};
+    }
+
+    void did_change(std::vector<ObserverState> const& observers, std::vector<void*> const&) override
+    {
+        ++did_change_count;
+        changed_observers = observers;
+    }
+
+    // Was the given column of the observed row changed by the last advance?
+    bool column_changed(size_t column) const
+    {
+        return changed_observers.size() == 1 && changed_observers[0].changes.size() > column &&
+               changed_observers[0].changes[column].changed;
+    }
+
+    size_t table_ndx;
+    size_t row_ndx;
+
+    size_t did_change_count = 0;
+    std::vector<ObserverState> changed_observers;
+};
+
+// A binding context which observes the given object types
+class TypeObservingContext : public realm::BindingContext {
+public:
+    TypeObservingContext(std::vector<std::string> object_types) : m_object_types(std::move(object_types)) { }
+
+    std::vector<std::string> get_observed_object_types() override
+    {
+        return m_object_types;
+    }
+
+private:
+    std::vector<std::string> m_object_types;
+};
+
+// A binding context which records the stats passed to did_commit()
+class CommitStatsContext : public realm::BindingContext {
+public:
+    void did_commit(realm::CommitStats const& stats) override
+    {
+        commits.push_back(stats);
+    }
+
+    std::vector<realm::CommitStats> commits;
+};
+} // anonymous namespace
+
+@interface ObjectStoreRealmTests : RLMTestCase
+@end
+
+@implementation ObjectStoreRealmTests
+
+#pragma mark - Observed object types
+
+// Check that a commit to an IntObject doesn't wake up `realm`, which only
+// observes StringObjects, but that one to a StringObject does
+- (void)assertOnlyObservedCommitsWake:(realm::SharedRealm)realm writer:(realm::SharedRealm)writer
+                        notifications:(std::atomic<int>&)notifications {
+    add_rows(*writer, 1, "IntObject");
+    run_for(0.2);
+    XCTAssertEqual(notifications.load(), 0);
+    XCTAssertEqual(table(*realm)->size(), 0U);
+
+    add_rows(*writer, 1, "StringObject");
+    XCTAssertTrue(run_until([&] { return table(*realm, "StringObject")->size() == 1; }));
+    XCTAssertEqual(notifications.load(), 1);
+    // Advancing for the observed commit also picks up the unobserved one
+    XCTAssertEqual(table(*realm)->size(), 1U);
+}
+
+- (void)testUnobservedCommitsDoNotWakeRealm {
+    auto writer = open_realm();
+    auto notifications = std::make_shared<std::atomic<int>>(0);
+    auto realm = open_realm([&](auto& config) {
+        config.scheduler = counting_scheduler(notifications);
+    });
+    realm->set_observed_object_types({"StringObject"});
+    [self assertOnlyObservedCommitsWake:realm writer:writer notifications:*notifications];
+}
+
+- (void)testBindingContextObservedTypesLimitWakeups {
+    auto writer = open_realm();
+    auto notifications = std::make_shared<std::atomic<int>>(0);
+    auto realm = open_realm([&](auto& config) {
+        config.scheduler = counting_scheduler(notifications);
+    });
+    realm->m_binding_context.reset(new TypeObservingContext({"StringObject"}));
+    // The binding context's types are picked up whenever the observed types
+    // are updated
+    realm->set_observed_object_types({});
+    [self assertOnlyObservedCommitsWake:realm writer:writer notifications:*notifications];
+}
+
+- (void)testObservingTypeWithSkippedCommitsWakesRealm {
+    auto writer = open_realm();
+    auto notifications = std::make_shared<std::atomic<int>>(0);
+    auto realm = open_realm([&](auto& config) {
+        config.scheduler = counting_scheduler(notifications);
+    });
+    realm->set_observed_object_types({"StringObject"});
+
+    add_rows(*writer, 1, "IntObject");
+    run_for(0.2);
+    XCTAssertEqual(notifications->load(), 0);
+
+    // The commit which was skipped is now relevant, so it's delivered without
+    // waiting for another commit
+    realm->set_observed_object_types({"IntObject"});
+    XCTAssertTrue(run_until([&] { return table(*realm)->size() == 1; }));
+}
+
+#pragma mark - Minimum notification interval
+
+- (void)testCommitsWithinMinimumIntervalAreCoalesced {
+    auto writer = open_realm();
+    auto notifications = std::make_shared<std::atomic<int>>(0);
+    auto realm = open_realm([&](auto& config) {
+        config.scheduler = counting_scheduler(notifications);
+        config.min_notification_interval = std::chrono::milliseconds(500);
+    });
+    realm->read_group();
+
+    // The first commit is delivered right away
+    add_rows(*writer, 1);
+    XCTAssertTrue(run_until([&] { return table(*realm)->size() == 1; }));
+    XCTAssertEqual(notifications->load(), 1);
+    auto first_delivery = std::chrono::steady_clock::now();
+
+    // Commits made within the interval are held back until it has passed,
+    // and then delivered together
+    for (int i = 0; i < 5; ++i) {
+        add_rows(*writer, 1);
+    }
+    run_for(0.1);
+    XCTAssertEqual(notifications->load(), 1);
+    XCTAssertEqual(table(*realm)->size(), 1U);
+
+    XCTAssertTrue(run_until([&] { return table(*realm)->size() == 6; }));
+    XCTAssertEqual(notifications->load(), 2);
+    // The first delivery was noticed a little after the interval started
+    XCTAssertTrue(std::chrono::steady_clock::now() - first_delivery > std::chrono::milliseconds(400));
+}
+
+- (void)testCommitsAfterMinimumIntervalAreDeliveredImmediately {
+    auto writer = open_realm();
+    auto notifications = std::make_shared<std::atomic<int>>(0);
+    auto realm = open_realm([&](auto& config) {
+        config.scheduler = counting_scheduler(notifications);
+        config.min_notification_interval = std::chrono::milliseconds(500);
+    });
+    realm->read_group();
+
+    add_rows(*writer, 1);
+    XCTAssertTrue(run_until([&] { return table(*realm)->size() == 1; }));
+    run_for(0.6);
+
+    // Nothing was delivered during the interval, so there's nothing to wait for
+    auto start = std::chrono::steady_clock::now();
+    add_rows(*writer, 1);
+    XCTAssertTrue(run_until([&] { return table(*realm)->size() == 2; }));
+    XCTAssertTrue(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(250));
+    XCTAssertEqual(notifications->load(), 2);
+}
+
+#pragma mark - Background change calculation
+
+- (void)testChangesCalculatedInBackgroundAreHandedOff {
+    auto writer = open_realm();
+    add_rows(*writer, 2);
+    auto scheduler = std::make_shared<realm::PollingScheduler>();
+    auto realm = open_realm([&](auto& config) {
+        config.scheduler = scheduler;
+        config.calculate_changes_in_background = true;
+    });
+    auto context = new RowObservingContext(table(*realm)->get_index_in_group());
+    realm->m_binding_context.reset(context);
+
+    writer->begin_transaction();
+    table(*writer)->set_int(0, 0, 5);
+    writer->commit_transaction();
+
+    // The first notification only starts calculating the changes, leaving
+    // the Realm at the old version
+    XCTAssertTrue(deliver_next(*scheduler));
+    XCTAssertEqual(context->did_change_count, 0U);
+    XCTAssertEqual(table(*realm)->get_int(0, 0), 0);
+
+    // The calculation notifies the scheduler when it's done, and the Realm
+    // then advances with the calculated changes
+    XCTAssertTrue(deliver_next(*scheduler));
+    XCTAssertEqual(context->did_change_count, 1U);
+    XCTAssertEqual(table(*realm)->get_int(0, 0), 5);
+    XCTAssertTrue(context->column_changed(0));
+}
+
+- (void)testChangesCalculatedForOtherObserversAreDiscarded {
+    auto writer = open_realm();
+    add_rows(*writer, 2);
+    auto scheduler = std::make_shared<realm::PollingScheduler>();
+    auto realm = open_realm([&](auto& config) {
+        config.scheduler = scheduler;
+        config.calculate_changes_in_background = true;
+    });
+    auto context = new RowObservingContext(table(*realm)->get_index_in_group());
+    realm->m_binding_context.reset(context);
+
+    writer->begin_transaction();
+    table(*writer)->set_int(0, 1, 5);
+    writer->commit_transaction();
+
+    // Start calculating the changes to row 0, and then switch to observing
+    // row 1 before they're delivered
+    XCTAssertTrue(deliver_next(*scheduler));
+    context->row_ndx = 1;
+
+    // The finished calculation no longer matches, so it's thrown away and
+    // redone for the new observers rather than advancing with it
+    XCTAssertTrue(deliver_next(*scheduler));
+    XCTAssertEqual(context->did_change_count, 0U);
+    XCTAssertEqual(table(*realm)->get_int(0, 1), 0);
+
+    XCTAssertTrue(deliver_next(*scheduler));
+    XCTAssertEqual(context->did_change_count, 1U);
+    XCTAssertEqual(table(*realm)->get_int(0, 1), 5);
+    XCTAssertEqual(context->changed_observers.size(), 1U);
+    XCTAssertEqual(context->changed_observers[0].row_ndx, 1U);
+    XCTAssertTrue(context->column_changed(0));
+}
+
+#pragma mark - Commit stats
+
+- (void)testCommitStatsDescribeTransaction {
+    auto realm = open_realm([](auto& config) {
+        config.record_commit_stats = true;
+    });
+    auto context = new CommitStatsContext;
+    realm->m_binding_context.reset(context);
+    add_rows(*realm, 1);
+
+    realm->begin_transaction();
+    auto ints = table(*realm);
+    ints->add_empty_row(3);
+    ints->set_int(0, 1, 5);
+    ints->move_last_over(0);
+    auto strings = table(*realm, "StringObject");
+    strings->set_string(0, strings->add_empty_row(), "hello");
+    realm->commit_transaction();
+
+    XCTAssertEqual(context->commits.size(), 2U);
+    auto const& stats = context->commits.back();
+    XCTAssertEqual(stats.version, realm->read_transaction_version().version);
+    XCTAssertGreaterThan(stats.transaction_log_size, 0U);
+    XCTAssertEqual(stats.schema_changes, 0U);
+
+    auto const& int_stats = stats.tables.at(ints->get_index_in_group());
+    XCTAssertEqual(int_stats.rows_inserted, 3U);
+    XCTAssertEqual(int_stats.rows_erased, 1U);
+    XCTAssertEqual(int_stats.values_set, 1U);
+    XCTAssertFalse(int_stats.cleared);
+
+    auto const& string_stats = stats.tables.at(strings->get_index_in_group());
+    XCTAssertEqual(string_stats.rows_inserted, 1U);
+    XCTAssertEqual(string_stats.values_set, 1U);
+    XCTAssertEqual(string_stats.string_bytes, 5U);
+
+    auto totals = stats.totals();
+    XCTAssertEqual(totals.rows_inserted, 4U);
+    XCTAssertEqual(totals.values_set, 2U);
+
+    // The stats passed to the binding context are the ones kept by the Realm
+    XCTAssertTrue(realm->last_commit_stats());
+    XCTAssertEqual(realm->last_commit_stats()->version, stats.version);
+    XCTAssertEqual(realm->last_commit_stats()->tables.size(), stats.tables.size());
+}
+
+- (void)testCommitStatsOnlyCoverLastCommit {
+    auto realm = open_realm([](auto& config) {
+        config.record_commit_stats = true;
+    });
+    add_rows(*realm, 2);
+    auto first_version = realm->last_commit_stats()->version;
+
+    realm->begin_transaction();
+    table(*realm)->clear();
+    realm->commit_transaction();
+
+    auto stats = realm->last_commit_stats();
+    XCTAssertGreaterThan(stats->version, first_version);
+    auto const& int_stats = stats->tables.at(table(*realm)->get_index_in_group());
+    XCTAssertEqual(int_stats.rows_inserted, 0U);
+    XCTAssertTrue(int_stats.cleared);
+}
+
+- (void)testCommitStatsNotRecordedByDefault {
+    auto realm = open_realm();
+    auto context = new CommitStatsContext;
+    realm->m_binding_context.reset(context);
+    add_rows(*realm, 1);
+
+    XCTAssertFalse(realm->last_commit_stats());
+    XCTAssertEqual(context->commits.size(), 0U);
+}
+
+#pragma mark - Change stream
+
+- (void)testChangeStreamReadsInsertModifyAndDelete {
+    auto realm = open_realm();
+    realm->begin_transaction();
+    add_object(*realm, "a", 1);
+    add_object(*realm, "b", 2);
+    realm->commit_transaction();
+    realm::ChangeStream stream(realm->config());
+
+    realm->begin_transaction();
+    add_object(*realm, "c", 3);
+    realm->commit_transaction();
+    auto changes = stream.read();
+    XCTAssertEqual(changes.size(), 1U);
+    XCTAssertTrue(changes[0].kind == realm::ObjectChange::Kind::Insert);
+    XCTAssertTrue(changes[0].object_type == "PrimaryKeyObject");
+    XCTAssertTrue(changes[0].primary_key.string_value == "c");
+    XCTAssertEqual(changes[0].row_ndx, 2U);
+    XCTAssertEqual(changes[0].values.size(), 2U);
+    XCTAssertEqual(change_value(changes[0], "value").int_value, 3);
+
+    // Modifications only include the properties which were changed
+    realm->begin_transaction();
+    table(*realm, "PrimaryKeyObject")->set_int(1, 0, 10);
+    realm->commit_transaction();
+    changes = stream.read();
+    XCTAssertEqual(changes.size(), 1U);
+    XCTAssertTrue(changes[0].kind == realm::ObjectChange::Kind::Modify);
+    XCTAssertTrue(changes[0].primary_key.string_value == "a");
+    XCTAssertEqual(changes[0].values.size(), 1U);
+    XCTAssertEqual(change_value(changes[0], "value").int_value, 10);
+
+    // Deleted objects no longer exist in the new version, so their primary
+    // keys are read from the old one
+    realm->begin_transaction();
+    table(*realm, "PrimaryKeyObject")->move_last_over(1);
+    realm->commit_transaction();
+    changes = stream.read();
+    XCTAssertEqual(changes.size(), 1U);
+    XCTAssertTrue(changes[0].kind == realm::ObjectChange::Kind::Delete);
+    XCTAssertTrue(changes[0].primary_key.string_value == "b");
+    XCTAssertEqual(changes[0].row_ndx, 1U);
+    XCTAssertTrue(changes[0].values.empty());
+
+    XCTAssertTrue(stream.version() == realm->read_transaction_version());
+    XCTAssertTrue(stream.read().empty());
+}
+
+- (void)testChangeStreamCoalescesCommits {
+    auto realm = open_realm();
+    realm::ChangeStream stream(realm->config());
+
+    // An object which is inserted and then modified is reported once with its
+    // final values, and one inserted and then deleted isn't reported at all
+    realm->begin_transaction();
+    add_object(*realm, "a", 1);
+    add_object(*realm, "b", 2);
+    realm->commit_transaction();
+    realm->begin_transaction();
+    table(*realm, "PrimaryKeyObject")->set_int(1, 0, 10);
+    table(*realm, "PrimaryKeyObject")->move_last_over(1);
+    realm->commit_transaction();
+
+    auto changes = stream.read();
+    XCTAssertEqual(changes.size(), 1U);
+    XCTAssertTrue(changes[0].kind == realm::ObjectChange::Kind::Insert);
+    XCTAssertTrue(changes[0].primary_key.string_value == "a");
+    XCTAssertEqual(change_value(changes[0], "value").int_value, 10);
+}
+
+- (void)testChangeStreamReportsClear {
+    auto realm = open_realm();
+    realm->begin_transaction();
+    add_object(*realm, "a", 1);
+    add_object(*realm, "b", 2);
+    realm->commit_transaction();
+    realm::ChangeStream stream(realm->config());
+
+    realm->begin_transaction();
+    table(*realm, "PrimaryKeyObject")->clear();
+    add_object(*realm, "c", 3);
+    realm->commit_transaction();
+
+    // The cleared objects can't be identified, so the clear is followed by
+    // every object which exists afterwards
+    auto changes = stream.read();
+    XCTAssertEqual(changes.size(), 2U);
+    XCTAssertTrue(changes[0].kind == realm::ObjectChange::Kind::Clear);
+    XCTAssertTrue(changes[0].object_type == "PrimaryKeyObject");
+    XCTAssertTrue(changes[1].kind == realm::ObjectChange::Kind::Insert);
+    XCTAssertTrue(changes[1].primary_key.string_value == "c");
+}
+
+- (void)testChangeStreamAppendsJSONLines {
+    auto realm = open_realm();
+    realm::ChangeStream stream(realm->config());
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+
+    realm->begin_transaction();
+    add_object(*realm, "a", 1);
+    realm->commit_transaction();
+    XCTAssertEqual(stream.append_to_file(path.UTF8String), 1U);
+    auto version = realm->read_transaction_version().version;
+
+    realm->begin_transaction();
+    table(*realm, "PrimaryKeyObject")->clear();
+    realm->commit_transaction();
+    XCTAssertEqual(stream.append_to_file(path.UTF8String), 1U);
+
+    auto lines = read_lines(path.UTF8String);
+    [NSFileManager.defaultManager removeItemAtPath:path error:nil];
+    XCTAssertEqual(lines.size(), 2U);
+    if (lines.size() != 2) {
+        return;
+    }
+    XCTAssertTrue(lines[0] == "{\"version\":" + std::to_string(version) + ",\"kind\":\"insert\",\"type\":\"PrimaryKeyObject\","
+                              "\"primaryKey\":\"a\",\"row\":0,\"values\":{\"id\":\"a\",\"value\":1}}");
+    XCTAssertTrue(lines[1] == "{\"version\":" + std::to_string(version + 1) + ",\"kind\":\"clear\",\"type\":\"PrimaryKeyObject\"}");
+}
+
+- (void)testChangeStreamStaysAtVersionIfAppendingFails {
+    auto realm = open_realm();
+    realm::ChangeStream stream(realm->config());
+    auto start = stream.version();
+
+    realm->begin_transaction();
+    add_object(*realm, "a", 1);
+    realm->commit_transaction();
+
+    // A directory can't be opened for writing
+    XCTAssertThrows(stream.append_to_file(NSTemporaryDirectory().UTF8String));
+    XCTAssertTrue(stream.version() == start);
+
+    // so the changes are written by the next call instead of being lost
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+    XCTAssertEqual(stream.append_to_file(path.UTF8String), 1U);
+    XCTAssertTrue(stream.version() == realm->read_transaction_version());
+    XCTAssertEqual(read_lines(path.UTF8String).size(), 1U);
+    [NSFileManager.defaultManager removeItemAtPath:path error:nil];
+}
+
+#pragma mark - Schema validation
+
+- (void)testUnrecordedSchemaChangeIsRejected {
+    auto writer = open_realm();
+    auto realm = open_realm();
+    add_rows(*writer, 1);
+    realm->refresh();
+
+    add_column_without_recording();
+    XCTAssertThrows(realm->refresh());
+}
+
+- (void)testUnrecordedSchemaChangeAfterRecordedCommitsIsRejected {
+    auto writer = open_realm();
+    auto realm = open_realm();
+    realm->read_group();
+
+    // The commits recorded by `writer` can be advanced over without
+    // validating, but not the one after them
+    add_rows(*writer, 1);
+    add_rows(*writer, 1);
+    add_column_without_recording();
+    XCTAssertThrows(realm->refresh());
+}
+
+#pragma mark - Refreshing to a version
+
+- (void)testRefreshToVersion {
+    auto writer = open_realm();
+    auto realm = open_realm();
+    realm->read_group();
+
+    std::vector<realm::SharedGroup::VersionID> versions;
+    for (int i = 0; i < 3; ++i) {
+        add_rows(*writer, 1);
+        versions.push_back(writer->read_transaction_version());
+    }
+
+    XCTAssertTrue(realm->refresh_to(versions[1]));
+    XCTAssertTrue(realm->read_transaction_version() == versions[1]);
+    XCTAssertEqual(table(*realm)->size(), 2U);
+
+    // Refreshing to an earlier version or the current one does nothing
+    XCTAssertFalse(realm->refresh_to(versions[0]));
+    XCTAssertFalse(realm->refresh_to(versions[1]));
+    XCTAssertEqual(table(*realm)->size(), 2U);
+
+    XCTAssertTrue(realm->refresh_to(versions[2]));
+    XCTAssertEqual(table(*realm)->size(), 3U);
+}
+
+- (void)testRefreshToUnavailableVersionThrows {
+    auto realm = open_realm();
+    auto current = realm->read_transaction_version();
+    XCTAssertThrows(realm->refresh_to(realm::SharedGroup::VersionID(current.version + 10, current.index)));
+    XCTAssertTrue(realm->read_transaction_version() == current);
+}
+
+- (void)testRefreshToInWriteTransactionThrows {
+    auto realm = open_realm();
+    auto version = realm->read_transaction_version();
+    realm->begin_transaction();
+    XCTAssertThrows(realm->refresh_to(version));
+    realm->cancel_transaction();
+}
+
+- (void)testNotifyAdvancesInSteps {
+    auto writer = open_realm();
+    auto scheduler = std::make_shared<realm::PollingScheduler>();
+    auto realm = open_realm([&](auto& config) {
+        config.scheduler = scheduler;
+        config.max_versions_per_step = 2;
+    });
+    realm->read_group();
+    for (int i = 0; i < 5; ++i) {
+        add_rows(*writer, 1);
+    }
+
+    // Each notification advances by at most two versions, and then asks the
+    // scheduler to come back for the rest
+    XCTAssertTrue(deliver_next(*scheduler));
+    XCTAssertEqual(table(*realm)->size(), 2U);
+    XCTAssertTrue(deliver_next(*scheduler));
+    XCTAssertEqual(table(*realm)->size(), 4U);
+    XCTAssertTrue(deliver_next(*scheduler));
+    XCTAssertEqual(table(*realm)->size(), 5U);
+    XCTAssertTrue(realm->read_transaction_version() == writer->read_transaction_version());
+}
+
+- (void)testRefreshIgnoresStepping {
+    auto writer = open_realm();
+    auto realm = open_realm([](auto& config) {
+        config.max_versions_per_step = 2;
+    });
+    realm->read_group();
+    for (int i = 0; i < 5; ++i) {
+        add_rows(*writer, 1);
+    }
+
+    XCTAssertTrue(realm->refresh());
+    XCTAssertEqual(table(*realm)->size(), 5U);
+}
+
+#pragma mark - Async writes
+
+// Make an async write with the Realm several commits behind the latest
+// version, and check that the completion isn't called until the Realm can see
+// the write
+- (void)assertAsyncWriteCompletionSeesWrite:(realm::SharedRealm)realm {
+    auto writer = open_realm();
+    add_rows(*writer, 1);
+    realm->read_group();
+    for (int i = 0; i < 5; ++i) {
+        add_rows(*writer, 1);
+    }
+
+    auto r = realm.get();
+    XCTestExpectation *expectation = [self expectationWithDescription:@"async write completed"];
+    realm->async_write([](realm::Realm& realm) {
+        table(realm)->add_empty_row();
+    }, [=](std::exception_ptr error, realm::SharedGroup::VersionID version) {
+        XCTAssertFalse(error);
+        XCTAssertGreaterThanOrEqual(r->read_transaction_version().version, version.version);
+        XCTAssertEqual(table(*r)->size(), 7U);
+        [expectation fulfill];
+    });
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+}
+
+- (void)testAsyncWriteCompletionSeesWrite {
+    [self assertAsyncWriteCompletionSeesWrite:open_realm()];
+}
+
+- (void)testAsyncWriteCompletionWaitsForSteppedAdvance {
+    [self assertAsyncWriteCompletionSeesWrite:open_realm([](auto& config) {
+        config.max_versions_per_step = 1;
+    })];
+}
+
+- (void)testAsyncWriteCompletionWaitsForBackgroundChangeCalculation {
+    auto realm = open_realm([](auto& config) {
+        config.calculate_changes_in_background = true;
+    });
+    realm->m_binding_context.reset(new RowObservingContext(table(*realm)->get_index_in_group()));
+    [self assertAsyncWriteCompletionSeesWrite:realm];
+}
+
+- (void)testAsyncWriteCompletionWaitsForManualRefreshWithoutAutoRefresh {
+    auto realm = open_realm();
+    realm->set_auto_refresh(false);
+    realm->read_group();
+
+    bool called = false;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"async write completed"];
+    realm->async_write([](realm::Realm& realm) {
+        table(realm)->add_empty_row();
+    }, [&, expectation](std::exception_ptr, realm::SharedGroup::VersionID) {
+        called = true;
+        [expectation fulfill];
+    });
+
+    // Wait for the write to be committed, and then give the scheduler a
+    // chance to (incorrectly) deliver the completion
+    auto reader = open_realm();
+    while (table(*reader)->size() == 0) {
+        [NSRunLoop.currentRunLoop runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+        reader->refresh();
+    }
+    [NSRunLoop.currentRunLoop runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    XCTAssertFalse(called);
+    XCTAssertEqual(table(*realm)->size(), 0U);
+
+    realm->refresh();
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+    XCTAssertEqual(table(*realm)->size(), 1U);
+}
+
+- (void)testAsyncWriteCompletionsAreCalledInOrder {
+    auto realm = open_realm();
+    realm->read_group();
+
+    // Writes which fail are reported in their place in the queue too
+    std::vector<int> order;
+    std::vector<bool> failed;
+    std::vector<uint64_t> versions;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"async writes completed"];
+    for (int i = 0; i < 10; ++i) {
+        realm->async_write([=](realm::Realm& realm) {
+            table(realm)->add_empty_row();
+            if (i == 5) {
+                throw std::runtime_error("write failed");
+            }
+        }, [&, i, expectation](std::exception_ptr error, realm::SharedGroup::VersionID version) {
+            order.push_back(i);
+            failed.push_back(bool(error));
+            if (!error) {
+                versions.push_back(version.version);
+            }
+            if (i == 9) {
+                [expectation fulfill];
+            }
+        });
+    }
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+
+    XCTAssertTrue(order == (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+    XCTAssertTrue(failed == (std::vector<bool>{false, false, false, false, false, true, false, false, false, false}));
+    // Writes which were committed together share a version
+    XCTAssertTrue(std::is_sorted(versions.begin(), versions.end()));
+    XCTAssertEqual(table(*realm)->size(), 9U);
+}
+
+- (void)testAsyncWriteCompletionNotCalledAfterRealmIsDestroyed {
+    auto realm = open_realm();
+    auto called = std::make_shared<bool>(false);
+    realm->async_write([](realm::Realm& realm) {
+        table(realm)->add_empty_row();
+    }, [=](std::exception_ptr, realm::SharedGroup::VersionID) {
+        *called = true;
+    });
+    realm.reset();
+
+    // The write itself still happens
+    auto reader = open_realm();
+    XCTAssertTrue(run_until([&] {
+        reader->refresh();
+        return table(*reader)->size() == 1;
+    }));
+    run_for(0.1);
+    XCTAssertFalse(*called);
+}
+
+- (void)testClearingCacheRightAfterAsyncWrite {
+    // The writer thread looks up its Realm in the cache while starting up,
+    // so closing the cached Realms must not wait for it with the cache locked
+    auto realm = open_realm([](auto& config) {
+        config.cache = true;
+    });
+    realm->async_write([](realm::Realm& realm) {
+        table(realm)->add_empty_row();
+    }, [](std::exception_ptr, realm::SharedGroup::VersionID) { });
+    XCTAssertNoThrow(realm::Realm::s_global_cache.clear());
+}
+
+@end
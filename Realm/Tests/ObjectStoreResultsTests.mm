@@ -0,0 +1,632 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+#import "RLMTestCase.h"
+
+#import "object_schema.hpp"
+#import "object_store.hpp"
+#import "property.hpp"
+#import "results.hpp"
+#import "schema.hpp"
+#import "shared_realm.hpp"
+
+#import <realm/datetime.hpp>
+#import <realm/table.hpp>
+
+#import <algorithm>
+#import <cmath>
+#import <vector>
+
+namespace {
+const size_t object_count = 100;
+
+realm::SharedRealm open_realm()
+{
+    realm::Property value;
+    value.name = "value";
+    value.type = realm::PropertyTypeInt;
+
+    realm::ObjectSchema object_schema;
+    object_schema.name = "IntObject";
+    object_schema.properties.push_back(value);
+
+    realm::Realm::Config config;
+    config.path = RLMTestRealmPath().UTF8String;
+    config.cache = false;
+    config.schema = std::make_unique<realm::Schema>(std::vector<realm::ObjectSchema>{object_schema});
+    config.schema_version = 0;
+    return realm::Realm::get_shared_realm(std::move(config));
+}
+
+realm::TableRef table(realm::Realm& realm)
+{
+    return realm::ObjectStore::table_for_object_type(realm.read_group(), "IntObject");
+}
+
+// The indices in the table of the rows in the Results, in order
+std::vector<size_t> row_indices(realm::Results& results)
+{
+    std::vector<size_t> indices;
+    for (size_t i = 0; i < results.size(); ++i) {
+        indices.push_back(results.get(i).get_index());
+    }
+    return indices;
+}
+
+// The part of `rows` which a window at `offset` of at most `count` rows holds
+std::vector<size_t> window(std::vector<size_t> const& rows, size_t offset, size_t count)
+{
+    offset = std::min(offset, rows.size());
+    count = std::min(count, rows.size() - offset);
+    return std::vector<size_t>(rows.begin() + offset, rows.begin() + offset + count);
+}
+
+// The indices in an IndexSet, expanded from its ranges
+std::vector<size_t> indices(realm::IndexSet const& set)
+{
+    std::vector<size_t> indices;
+    for (auto range : set) {
+        for (size_t i = range.first; i < range.second; ++i) {
+            indices.push_back(i);
+        }
+    }
+    return indices;
+}
+
+template<typename Func>
+bool throws_window_exception(Func&& func)
+{
+    try {
+        func();
+    }
+    catch (realm::Results::UnsupportedWindowOperationException const&) {
+        return true;
+    }
+    return false;
+}
+} // anonymous namespace
+
+@interface ObjectStoreResultsTests : RLMTestCase
+@end
+
+@implementation ObjectStoreResultsTests {
+    realm::SharedRealm _realm;
+}
+
+- (void)setUp {
+    [super setUp];
+
+    // Each value appears twice so that sorting has ties to break
+    _realm = open_realm();
+    _realm->begin_transaction();
+    auto t = table(*_realm);
+    t->add_empty_row(object_count);
+    for (size_t i = 0; i < object_count; ++i) {
+        t->set_int(0, i, (i * 37) % (object_count / 2));
+    }
+    _realm->commit_transaction();
+}
+
+- (void)tearDown {
+    _realm = nullptr;
+    [super tearDown];
+}
+
+- (realm::Results)query {
+    return realm::Results(_realm, table(*_realm)->where().less(0, int64_t(40)));
+}
+
+- (realm::Results)sortedQuery {
+    return realm::Results(_realm, table(*_realm)->where().less(0, int64_t(40)), {{0}, {true}});
+}
+
+- (void)assertWindowsOf:(realm::Results)results {
+    auto all = row_indices(results);
+    XCTAssertGreaterThan(all.size(), 20U);
+
+    auto check = [&](realm::Results windowed, size_t offset, size_t count) {
+        XCTAssertTrue(row_indices(windowed) == window(all, offset, count),
+                      @"window at %zu of %zu rows", offset, count);
+    };
+    check(results.limit(0), 0, 0);
+    check(results.limit(1), 0, 1);
+    check(results.limit(10), 0, 10);
+    check(results.slice(0, 0), 0, 0);
+    check(results.slice(5, 0), 5, 0);
+    check(results.slice(5, 10), 5, 10);
+    check(results.slice(all.size() - 3, 10), all.size() - 3, 10);
+    check(results.limit(all.size()), 0, all.size());
+}
+
+- (void)testWindowOfUnsortedQuery {
+    [self assertWindowsOf:self.query];
+}
+
+- (void)testWindowOfTable {
+    [self assertWindowsOf:realm::Results(_realm, *table(*_realm))];
+}
+
+- (void)testWindowOfSortedQuery {
+    // Windows which end well before the number of rows in the table keep
+    // the first rows in a heap rather than sorting every match
+    [self assertWindowsOf:self.sortedQuery];
+    [self assertWindowsOf:realm::Results(_realm, *table(*_realm)).sort({{0}, {false}})];
+}
+
+- (void)testWindowOfSortedQueryLargerThanTable {
+    // Windows which end past the number of rows in the table sort every match
+    auto results = self.sortedQuery;
+    auto all = row_indices(results);
+    XCTAssertTrue(row_indices(results.limit(object_count)) == all);
+    XCTAssertTrue(row_indices(results.slice(10, object_count)) == window(all, 10, object_count));
+    XCTAssertTrue(row_indices(results.limit(realm::npos)) == all);
+}
+
+- (void)testWindowStartingPastEnd {
+    for (auto results : {self.query, self.sortedQuery}) {
+        size_t size = results.size();
+        XCTAssertEqual(results.slice(size, 5).size(), 0U);
+        XCTAssertEqual(results.slice(size + 10, 5).size(), 0U);
+        XCTAssertEqual(results.slice(object_count * 2, 5).size(), 0U);
+        XCTAssertFalse(results.slice(size, 5).first());
+        XCTAssertFalse(results.slice(size, 5).last());
+    }
+}
+
+- (void)testNestedWindows {
+    for (auto results : {self.query, self.sortedQuery}) {
+        auto all = row_indices(results);
+        XCTAssertTrue(row_indices(results.slice(10, 20).slice(5, 10)) == window(all, 15, 10));
+        XCTAssertTrue(row_indices(results.slice(10, 20).limit(5)) == window(all, 10, 5));
+        // The inner window can't extend past the end of the outer one
+        XCTAssertTrue(row_indices(results.slice(10, 5).slice(3, 10)) == window(all, 13, 2));
+        XCTAssertTrue(row_indices(results.limit(5).limit(10)) == window(all, 0, 5));
+        // An inner window which starts past the end of the outer one is empty
+        XCTAssertEqual(results.slice(10, 5).slice(10, 3).size(), 0U);
+        XCTAssertEqual(results.limit(5).slice(5, 3).size(), 0U);
+    }
+}
+
+- (void)testSortAndFilterOfWindow {
+    // The window is applied to the sorted or filtered rows
+    auto descending = realm::Results(_realm, table(*_realm)->where().less(0, int64_t(40)), {{0}, {false}});
+    XCTAssertTrue(row_indices(self.query.slice(5, 10).sort({{0}, {false}})) == window(row_indices(descending), 5, 10));
+
+    auto filtered = realm::Results(_realm, table(*_realm)->where().less(0, int64_t(40)).greater(0, int64_t(10)), {{0}, {true}});
+    auto q = table(*_realm)->where().greater(0, int64_t(10));
+    XCTAssertTrue(row_indices(self.sortedQuery.slice(5, 10).filter(std::move(q))) == window(row_indices(filtered), 5, 10));
+}
+
+- (void)testWindowTracksChanges {
+    auto results = self.sortedQuery;
+    auto windowed = results.slice(5, 10);
+    XCTAssertTrue(row_indices(windowed) == window(row_indices(results), 5, 10));
+
+    _realm->begin_transaction();
+    auto t = table(*_realm);
+    t->set_int(0, t->add_empty_row(), 0);
+    t->move_last_over(7);
+    _realm->commit_transaction();
+
+    XCTAssertTrue(row_indices(windowed) == window(row_indices(results), 5, 10));
+}
+
+- (void)testClearWindow {
+    auto t = table(*_realm);
+    for (auto results : {self.query, self.sortedQuery}) {
+        auto windowed = results.slice(5, 10);
+        std::vector<int64_t> expected;
+        for (size_t i = 0; i < t->size(); ++i) {
+            expected.push_back(t->get_int(0, i));
+        }
+        for (auto row_ndx : row_indices(windowed)) {
+            expected.erase(std::find(expected.begin(), expected.end(), t->get_int(0, row_ndx)));
+        }
+
+        _realm->begin_transaction();
+        windowed.clear();
+        _realm->commit_transaction();
+
+        std::vector<int64_t> actual;
+        for (size_t i = 0; i < t->size(); ++i) {
+            actual.push_back(t->get_int(0, i));
+        }
+        std::sort(expected.begin(), expected.end());
+        std::sort(actual.begin(), actual.end());
+        XCTAssertTrue(actual == expected);
+    }
+
+    // Clearing an empty window deletes nothing
+    size_t size = t->size();
+    _realm->begin_transaction();
+    self.sortedQuery.limit(0).clear();
+    _realm->commit_transaction();
+    XCTAssertEqual(t->size(), size);
+}
+
+- (void)assertIndexOfMatchesRows:(realm::Results&)results {
+    auto rows = row_indices(results);
+    auto t = table(*_realm);
+    for (size_t row_ndx = 0; row_ndx < t->size(); ++row_ndx) {
+        auto it = std::find(rows.begin(), rows.end(), row_ndx);
+        size_t expected = it == rows.end() ? realm::not_found : it - rows.begin();
+        XCTAssertEqual(results.index_of(row_ndx), expected, @"row %zu", row_ndx);
+    }
+}
+
+- (void)testIndexOfWindow {
+    for (auto results : {self.query, self.sortedQuery}) {
+        auto windowed = results.slice(5, 20);
+        [self assertIndexOfMatchesRows:windowed];
+
+        _realm->begin_transaction();
+        table(*_realm)->move_last_over(3);
+        _realm->commit_transaction();
+        [self assertIndexOfMatchesRows:windowed];
+    }
+}
+
+- (void)testIndexOfIncrementalResults {
+    for (auto results : {self.query, self.sortedQuery}) {
+        results.enable_incremental_updates();
+        [self assertIndexOfMatchesRows:results];
+
+        // Inside a write transaction the TableView is used rather than the
+        // incrementally updated rows
+        _realm->begin_transaction();
+        auto t = table(*_realm);
+        [self assertIndexOfMatchesRows:results];
+        t->set_int(0, 10, 5);
+        t->set_int(0, t->add_empty_row(), 1);
+        t->move_last_over(2);
+        [self assertIndexOfMatchesRows:results];
+        _realm->commit_transaction();
+        [self assertIndexOfMatchesRows:results];
+
+        _realm->begin_transaction();
+        _realm->commit_transaction();
+        [self assertIndexOfMatchesRows:results];
+    }
+}
+
+- (void)testUnsupportedWindowOperations {
+    auto windowed = self.sortedQuery.limit(5);
+    XCTAssertTrue(throws_window_exception([&] { windowed.get_tableview(); }));
+    XCTAssertTrue(throws_window_exception([&] { windowed.add_notification_callback([](realm::CollectionChangeSet const&) { }); }));
+    XCTAssertTrue(throws_window_exception([&] { windowed.enable_incremental_updates(); }));
+
+    // The Results the window was made from are unaffected
+    auto results = self.sortedQuery;
+    XCTAssertFalse(throws_window_exception([&] { results.get_tableview(); }));
+}
+
+- (void)testNotificationForInsertion {
+    auto results = self.query;
+    size_t size = results.size();
+    std::vector<realm::CollectionChangeSet> changes;
+    auto token = results.add_notification_callback([&](auto const& c) { changes.push_back(c); });
+
+    _realm->begin_transaction();
+    auto t = table(*_realm);
+    t->set_int(0, t->add_empty_row(), 0);
+    _realm->commit_transaction();
+
+    XCTAssertEqual(changes.size(), 1U);
+    XCTAssertTrue(indices(changes[0].insertions) == std::vector<size_t>{size});
+    XCTAssertTrue(changes[0].deletions.empty());
+    XCTAssertTrue(changes[0].modifications.empty());
+    XCTAssertTrue(changes[0].moves.empty());
+}
+
+- (void)testNotificationForDeletion {
+    // The last row in the table matches the query, so it's also the last row
+    // in the results and removing it doesn't move any other rows
+    auto results = self.query;
+    size_t size = results.size();
+    XCTAssertEqual(row_indices(results).back(), object_count - 1);
+    std::vector<realm::CollectionChangeSet> changes;
+    auto token = results.add_notification_callback([&](auto const& c) { changes.push_back(c); });
+
+    _realm->begin_transaction();
+    table(*_realm)->move_last_over(object_count - 1);
+    _realm->commit_transaction();
+
+    XCTAssertEqual(changes.size(), 1U);
+    XCTAssertTrue(indices(changes[0].deletions) == std::vector<size_t>{size - 1});
+    XCTAssertTrue(changes[0].insertions.empty());
+    XCTAssertTrue(changes[0].modifications.empty());
+    XCTAssertTrue(changes[0].moves.empty());
+}
+
+- (void)testNotificationForModification {
+    auto results = self.query;
+    std::vector<realm::CollectionChangeSet> changes;
+    auto token = results.add_notification_callback([&](auto const& c) { changes.push_back(c); });
+
+    _realm->begin_transaction();
+    table(*_realm)->set_int(0, results.get(2).get_index(), 1);
+    _realm->commit_transaction();
+
+    XCTAssertEqual(changes.size(), 1U);
+    XCTAssertTrue(indices(changes[0].modifications) == std::vector<size_t>{2});
+    XCTAssertTrue(changes[0].insertions.empty());
+    XCTAssertTrue(changes[0].deletions.empty());
+    XCTAssertTrue(changes[0].moves.empty());
+}
+
+- (void)testNotificationForMove {
+    // Giving the first row in the sorted results the largest value which
+    // still matches moves it towards the end
+    auto results = self.sortedQuery;
+    size_t row = results.get(0).get_index();
+    std::vector<realm::CollectionChangeSet> changes;
+    auto token = results.add_notification_callback([&](auto const& c) { changes.push_back(c); });
+
+    _realm->begin_transaction();
+    table(*_realm)->set_int(0, row, 39);
+    _realm->commit_transaction();
+
+    auto rows = row_indices(results);
+    size_t new_ndx = std::find(rows.begin(), rows.end(), row) - rows.begin();
+    XCTAssertGreaterThan(new_ndx, 0U);
+
+    XCTAssertEqual(changes.size(), 1U);
+    XCTAssertEqual(changes[0].moves.size(), 1U);
+    XCTAssertEqual(changes[0].moves[0].from, 0U);
+    XCTAssertEqual(changes[0].moves[0].to, new_ndx);
+    // Moves are also reported as a deletion and an insertion
+    XCTAssertTrue(indices(changes[0].deletions) == std::vector<size_t>{0});
+    XCTAssertTrue(indices(changes[0].insertions) == std::vector<size_t>{new_ndx});
+    XCTAssertTrue(indices(changes[0].modifications) == std::vector<size_t>{new_ndx});
+}
+
+- (void)testNoNotificationForChangesOutsideResults {
+    auto results = self.query;
+    size_t row = 0;
+    while (table(*_realm)->get_int(0, row) < 40) {
+        ++row;
+    }
+    size_t calls = 0;
+    auto token = results.add_notification_callback([&](auto const&) { ++calls; });
+
+    _realm->begin_transaction();
+    table(*_realm)->set_int(0, row, 45);
+    _realm->commit_transaction();
+    XCTAssertEqual(calls, 0U);
+}
+
+- (void)testNotificationForCommitByAnotherRealm {
+    auto results = self.query;
+    size_t size = results.size();
+    std::vector<realm::CollectionChangeSet> changes;
+    auto token = results.add_notification_callback([&](auto const& c) { changes.push_back(c); });
+
+    auto writer = open_realm();
+    writer->begin_transaction();
+    table(*writer)->add_empty_row();
+    writer->commit_transaction();
+    XCTAssertEqual(changes.size(), 0U);
+
+    _realm->refresh();
+    XCTAssertEqual(changes.size(), 1U);
+    XCTAssertTrue(indices(changes[0].insertions) == std::vector<size_t>{size});
+}
+
+- (void)testNoNotificationAfterTokenIsDestroyed {
+    auto results = self.query;
+    size_t calls = 0;
+    {
+        auto token = results.add_notification_callback([&](auto const&) { ++calls; });
+    }
+
+    _realm->begin_transaction();
+    table(*_realm)->add_empty_row();
+    _realm->commit_transaction();
+    XCTAssertEqual(calls, 0U);
+}
+
+@end
+
+namespace {
+// Enough rows for aggregates to be split between threads, which needs at
+// least two of ParallelAggregates::min_chunk_size
+const size_t aggregate_object_count = 200000;
+
+realm::SharedRealm open_aggregate_realm(size_t aggregate_threads)
+{
+    realm::ObjectSchema object_schema;
+    object_schema.name = "AggregateObject";
+    for (auto type : {realm::PropertyTypeInt, realm::PropertyTypeFloat, realm::PropertyTypeDouble, realm::PropertyTypeDate}) {
+        realm::Property property;
+        property.name = realm::string_for_property_type(type);
+        property.type = type;
+        property.is_nullable = true;
+        object_schema.properties.push_back(property);
+    }
+
+    realm::Realm::Config config;
+    config.path = RLMTestRealmPath().UTF8String;
+    config.cache = false;
+    config.schema = std::make_unique<realm::Schema>(std::vector<realm::ObjectSchema>{object_schema});
+    config.schema_version = 0;
+    config.aggregate_threads = aggregate_threads;
+    return realm::Realm::get_shared_realm(std::move(config));
+}
+
+realm::TableRef aggregate_table(realm::Realm& realm)
+{
+    return realm::ObjectStore::table_for_object_type(realm.read_group(), "AggregateObject");
+}
+} // anonymous namespace
+
+@interface ParallelAggregateTests : RLMTestCase
+@end
+
+@implementation ParallelAggregateTests {
+    // Realms for the same file which evaluate aggregates on one thread and
+    // on several threads
+    realm::SharedRealm _serial;
+    realm::SharedRealm _parallel;
+}
+
+- (void)setUp {
+    [super setUp];
+
+    _serial = open_aggregate_realm(0);
+    _parallel = open_aggregate_realm(3);
+
+    // Each column has nulls at a different interval
+    _serial->begin_transaction();
+    auto t = aggregate_table(*_serial);
+    t->add_empty_row(aggregate_object_count);
+    for (size_t i = 0; i < aggregate_object_count; ++i) {
+        if (i % 7 == 0)
+            t->set_null(0, i);
+        else
+            t->set_int(0, i, int64_t(i * 7919 % 100003) - 50000);
+        if (i % 11 == 0)
+            t->set_null(1, i);
+        else
+            t->set_float(1, i, float(i % 1000) * 0.5f - 100);
+        if (i % 13 == 0)
+            t->set_null(2, i);
+        else
+            t->set_double(2, i, double(i * 104729 % 1000003) * 0.25);
+        if (i % 17 == 0)
+            t->set_null(3, i);
+        else
+            t->set_datetime(3, i, realm::DateTime(int64_t(i * 31 % 1000000)));
+    }
+    _serial->commit_transaction();
+    _parallel->refresh();
+}
+
+- (void)tearDown {
+    _serial = nullptr;
+    _parallel = nullptr;
+    [super tearDown];
+}
+
+- (void)assertAggregate:(realm::util::Optional<realm::Mixed>)parallel
+                 equals:(realm::util::Optional<realm::Mixed>)serial
+                 column:(size_t)column {
+    XCTAssertEqual(bool(parallel), bool(serial), @"column %zu", column);
+    if (!parallel || !serial) {
+        return;
+    }
+    XCTAssertEqual(parallel->get_type(), serial->get_type(), @"column %zu", column);
+    switch (serial->get_type()) {
+        case realm::type_Int:
+            XCTAssertEqual(parallel->get_int(), serial->get_int(), @"column %zu", column);
+            break;
+        case realm::type_Float:
+            XCTAssertEqual(parallel->get_float(), serial->get_float(), @"column %zu", column);
+            break;
+        case realm::type_Double:
+            // Sums of floating point values depend on the order they're added in
+            XCTAssertEqualWithAccuracy(parallel->get_double(), serial->get_double(),
+                                       std::abs(serial->get_double()) * 1e-9, @"column %zu", column);
+            break;
+        case realm::type_DateTime:
+            XCTAssertEqual(parallel->get_datetime().get_datetime(), serial->get_datetime().get_datetime(), @"column %zu", column);
+            break;
+        default:
+            XCTFail(@"unexpected aggregate type for column %zu", column);
+    }
+}
+
+// Compare every aggregate of every column between the Results from `make`
+// for the serial and parallel Realms
+- (void)assertAggregatesMatch:(realm::Results (^)(realm::SharedRealm const&))make {
+    auto serial = make(_serial);
+    auto parallel = make(_parallel);
+    XCTAssertEqual(serial.size(), parallel.size());
+    for (size_t column = 0; column < 4; ++column) {
+        [self assertAggregate:parallel.min(column) equals:serial.min(column) column:column];
+        [self assertAggregate:parallel.max(column) equals:serial.max(column) column:column];
+        // DateTime columns don't support sum() and average()
+        if (column == 3) {
+            continue;
+        }
+        [self assertAggregate:parallel.sum(column) equals:serial.sum(column) column:column];
+        [self assertAggregate:parallel.average(column) equals:serial.average(column) column:column];
+    }
+}
+
+- (void)testTable {
+    [self assertAggregatesMatch:^(realm::SharedRealm const& shared_realm) {
+        return realm::Results(shared_realm, *aggregate_table(*shared_realm));
+    }];
+}
+
+- (void)testQuery {
+    [self assertAggregatesMatch:^(realm::SharedRealm const& shared_realm) {
+        return realm::Results(shared_realm, aggregate_table(*shared_realm)->where().greater(0, int64_t(-40000)));
+    }];
+}
+
+- (void)testTableView {
+    // Sorted, so the view isn't in table order
+    [self assertAggregatesMatch:^(realm::SharedRealm const& shared_realm) {
+        realm::Results results(shared_realm, aggregate_table(*shared_realm)->where().greater(0, int64_t(-40000)), {{2}, {false}});
+        results.get(0);
+        return results;
+    }];
+}
+
+- (void)testWindow {
+    [self assertAggregatesMatch:^(realm::SharedRealm const& shared_realm) {
+        realm::Results results(shared_realm, aggregate_table(*shared_realm)->where(), {{0}, {true}});
+        return results.slice(1000, aggregate_object_count - 2000);
+    }];
+}
+
+- (void)testIncremental {
+    [self assertAggregatesMatch:^(realm::SharedRealm const& shared_realm) {
+        realm::Results results(shared_realm, aggregate_table(*shared_realm)->where().greater(0, int64_t(-40000)));
+        results.enable_incremental_updates();
+        return results;
+    }];
+}
+
+- (void)testAllNull {
+    _serial->begin_transaction();
+    auto t = aggregate_table(*_serial);
+    for (size_t i = 0; i < aggregate_object_count; ++i) {
+        for (size_t column = 0; column < 4; ++column) {
+            t->set_null(column, i);
+        }
+    }
+    _serial->commit_transaction();
+    _parallel->refresh();
+
+    [self testTable];
+}
+
+- (void)testInWriteTransaction {
+    // The workers can't see uncommitted changes, so the calling thread
+    // evaluates the aggregates itself
+    _parallel->begin_transaction();
+    aggregate_table(*_parallel)->set_int(0, 1, 1000000);
+    realm::Results results(_parallel, *aggregate_table(*_parallel));
+    XCTAssertEqual(results.max(0)->get_int(), 1000000);
+    _parallel->cancel_transaction();
+}
+
+@end
@@ -21,6 +21,8 @@
 #import "RLMRealm_Dynamic.h"
 #import "RLMRealm_Private.h"
 
+#import <mach/mach.h>
+
 #if !DEBUG && TARGET_OS_IPHONE && !TARGET_IPHONE_SIMULATOR
 
 @interface PerformanceTests : RLMTestCase
@@ -30,6 +32,20 @@
 
 static RLMRealm *s_smallRealm, *s_mediumRealm, *s_largeRealm;
 
+// The number of threads in the process
+static NSUInteger threadCount(void) {
+    thread_act_array_t threads;
+    mach_msg_type_number_t count = 0;
+    if (task_threads(mach_task_self(), &threads, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    for (mach_msg_type_number_t i = 0; i < count; ++i) {
+        mach_port_deallocate(mach_task_self(), threads[i]);
+    }
+    vm_deallocate(mach_task_self(), (vm_address_t)threads, count * sizeof(thread_act_t));
+    return count;
+}
+
 @implementation PerformanceTests
 
 + (void)setUp {
@@ -402,6 +418,23 @@ static RLMRealm *s_smallRealm, *s_mediumRealm, *s_largeRealm;
     }];
 }
 
+- (void)testRealmFileCreationWithManyOpenFiles {
+    RLMRealmConfiguration *config = [RLMRealmConfiguration new];
+    __block int measurement = 0;
+    const int iterations = 200;
+    [self measureBlock:^{
+        @autoreleasepool {
+            NSMutableArray *realms = [NSMutableArray arrayWithCapacity:iterations];
+            for (int i = 0; i < iterations; ++i) {
+                config.inMemoryIdentifier = [NSString stringWithFormat:@"many-%d", measurement * iterations + i];
+                [realms addObject:[RLMRealm realmWithConfiguration:config error:nil]];
+            }
+            [realms removeAllObjects];
+        }
+        ++measurement;
+    }];
+}
+
 - (void)testCommitWriteTransaction {
     [self measureMetrics:self.class.defaultPerformanceMetrics automaticallyStartMeasuring:NO forBlock:^{
         RLMRealm *realm = self.testRealm;
@@ -480,6 +513,27 @@ static RLMRealm *s_smallRealm, *s_mediumRealm, *s_largeRealm;
 }
 
 - (void)testCrossThreadSyncLatency {
+    [self measureCrossThreadSyncLatency];
+}
+
+- (void)testCrossThreadSyncLatencyWithManyOpenFiles {
+    // Commits to every open file are waited for by a single notifier thread,
+    // so opening lots of files shouldn't start more threads or slow down
+    // delivering the notifications for any one of them
+    NSUInteger initialThreadCount = threadCount();
+    RLMRealmConfiguration *config = [RLMRealmConfiguration new];
+    NSMutableArray *realms = [NSMutableArray arrayWithCapacity:200];
+    for (int i = 0; i < 200; ++i) {
+        config.inMemoryIdentifier = [NSString stringWithFormat:@"open-while-syncing-%d", i];
+        [realms addObject:[RLMRealm realmWithConfiguration:config error:nil]];
+    }
+    XCTAssertLessThan(threadCount(), initialThreadCount + 5);
+
+    [self measureCrossThreadSyncLatency];
+    [realms removeAllObjects];
+}
+
+- (void)measureCrossThreadSyncLatency {
     const int stopValue = 500;
 
     [self measureMetrics:self.class.defaultPerformanceMetrics automaticallyStartMeasuring:NO forBlock:^{
@@ -649,6 +703,59 @@ static RLMRealm *s_smallRealm, *s_mediumRealm, *s_largeRealm;
     }];
 }
 
+- (void)measureDeletingObjects:(NSUInteger)deleteCount whileObserving:(NSUInteger)observeCount {
+    [self measureMetrics:self.class.defaultPerformanceMetrics automaticallyStartMeasuring:NO forBlock:^{
+        RLMRealm *realm = [self getStringObjects:5];
+        const NSUInteger remaining = [StringObject allObjectsInRealm:realm].count - deleteCount;
+
+        self.sema = dispatch_semaphore_create(0);
+        self.queue = dispatch_queue_create("bg", 0);
+
+        RLMRealmConfiguration *config = realm.configuration;
+        dispatch_async(_queue, ^{
+            RLMRealm *realm = [RLMRealm realmWithConfiguration:config error:nil];
+            RLMResults *objects = [StringObject allObjectsInRealm:realm];
+            NSMutableArray *observed = [NSMutableArray arrayWithCapacity:observeCount];
+            for (NSUInteger i = 0; i < observeCount; ++i) {
+                StringObject *obj = objects[i];
+                [obj addObserver:self forKeyPath:@"stringCol" options:(NSKeyValueObservingOptions)0 context:NULL];
+                [observed addObject:obj];
+            }
+
+            dispatch_semaphore_signal(_sema);
+            while (objects.count > remaining) {
+                [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate distantFuture]];
+            }
+
+            for (StringObject *obj in observed) {
+                [obj removeObserver:self forKeyPath:@"stringCol" context:NULL];
+            }
+        });
+        dispatch_semaphore_wait(_sema, DISPATCH_TIME_FOREVER);
+
+        [self startMeasuring];
+        RLMResults *objects = [StringObject allObjectsInRealm:realm];
+        [realm beginWriteTransaction];
+        while (objects.count > remaining) {
+            [realm deleteObject:objects.firstObject];
+        }
+        [realm commitWriteTransaction];
+        dispatch_sync(_queue, ^{});
+    }];
+}
+
+- (void)testDeleteFewObjectsWhileObservingMany {
+    [self measureDeletingObjects:1000 whileObserving:10000];
+}
+
+- (void)testDeleteManyObjectsWhileObservingFew {
+    [self measureDeletingObjects:10000 whileObserving:1000];
+}
+
+- (void)testDeleteManyObjectsWhileObservingMany {
+    [self measureDeletingObjects:10000 whileObserving:10000];
+}
+
 - (void)observeObject:(RLMObject *)object keyPath:(NSString *)keyPath until:(int (^)(id))block {
     self.sema = dispatch_semaphore_create(0);
     self.queue = dispatch_queue_create("bg", 0);
@@ -674,7 +781,9 @@ static RLMRealm *s_smallRealm, *s_mediumRealm, *s_largeRealm;
                       ofObject:(__unused id)object
                         change:(__unused NSDictionary *)change
                        context:(void *)context {
-    dispatch_semaphore_signal((__bridge dispatch_semaphore_t)context);
+    if (context) {
+        dispatch_semaphore_signal((__bridge dispatch_semaphore_t)context);
+    }
 }
 
 @end
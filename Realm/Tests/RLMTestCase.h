@@ -27,6 +27,7 @@ NSString *RLMTestRealmPath(void);
 NSString *RLMDefaultRealmPath(void);
 NSString *RLMRealmPathForFile(NSString *);
 NSData *RLMGenerateKey(void);
+void RLMDeleteRealmFilesAtPath(NSString *path);
 #ifdef __cplusplus
 }
 #endif
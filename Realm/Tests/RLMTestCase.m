@@ -54,6 +54,13 @@ static void deleteOrThrow(NSString *path) {
     }
 }
 
+void RLMDeleteRealmFilesAtPath(NSString *path) {
+    for (NSString *suffix in @[@"", @".lock", @".note", @".commit", @".write", @".management",
+                               @".log", @".log_a", @".log_b"]) {
+        deleteOrThrow([path stringByAppendingString:suffix]);
+    }
+}
+
 NSData *RLMGenerateKey() {
     uint8_t buffer[64];
     SecRandomCopyBytes(kSecRandomDefault, 64, buffer);
@@ -142,9 +149,7 @@ static BOOL encryptTests() {
 
 - (void)deleteRealmFileAtPath:(NSString *)path
 {
-    deleteOrThrow(path);
-    deleteOrThrow([path stringByAppendingString:@".lock"]);
-    deleteOrThrow([path stringByAppendingString:@".note"]);
+    RLMDeleteRealmFilesAtPath(path);
 }
 
 - (void)invokeTest {
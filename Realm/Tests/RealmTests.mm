@@ -26,6 +26,71 @@ extern "C" {
 #import "RLMSchema_Private.h"
 }
 
+#import "binding_context.hpp"
+#import "object_schema.hpp"
+#import "object_store.hpp"
+#import "property.hpp"
+#import "scheduler.hpp"
+#import "schema.hpp"
+#import "shared_realm.hpp"
+
+#import <realm/table.hpp>
+
+namespace {
+// Counts the notifications sent to a binding context which observes the
+// first row of a table, and whether its Realm was in a write transaction at
+// the time of the last one
+class CountingBindingContext : public realm::BindingContext {
+public:
+    CountingBindingContext(realm::Realm& realm, size_t table_ndx) : m_realm(realm), m_table_ndx(table_ndx) { }
+
+    size_t will_change_count = 0;
+    size_t did_change_count = 0;
+    bool did_change_in_write = false;
+
+    std::vector<ObserverState> get_observed_rows() override
+    {
+        return {{m_table_ndx, 0, nullptr, {}}};
+    }
+
+    void will_change(std::vector<ObserverState> const&, std::vector<void*> const&) override
+    {
+        ++will_change_count;
+    }
+
+    void did_change(std::vector<ObserverState> const&, std::vector<void*> const&) override
+    {
+        ++did_change_count;
+        did_change_in_write = m_realm.is_in_transaction();
+    }
+
+private:
+    realm::Realm& m_realm;
+    size_t m_table_ndx;
+};
+
+realm::SharedRealm open_int_object_realm(bool advance_before_write_lock = false,
+                                         std::shared_ptr<realm::Scheduler> scheduler = nullptr)
+{
+    realm::Property value;
+    value.name = "value";
+    value.type = realm::PropertyTypeInt;
+
+    realm::ObjectSchema object_schema;
+    object_schema.name = "IntObject";
+    object_schema.properties.push_back(value);
+
+    realm::Realm::Config config;
+    config.path = RLMTestRealmPath().UTF8String;
+    config.cache = false;
+    config.schema = std::make_unique<realm::Schema>(std::vector<realm::ObjectSchema>{object_schema});
+    config.schema_version = 0;
+    config.advance_before_write_lock = advance_before_write_lock;
+    config.scheduler = std::move(scheduler);
+    return realm::Realm::get_shared_realm(std::move(config));
+}
+} // anonymous namespace
+
 @interface RLMRealm ()
 + (BOOL)isCoreDebug;
 - (BOOL)compact;
@@ -110,10 +175,11 @@ extern "C" {
         [realm commitWriteTransaction];
     }
 
-    // Delete `*.lock` and `.note` files to simulate opening Realm in an app bundle
+    // Delete `*.lock`, `.note` and `.commit` files to simulate opening Realm in an app bundle
     NSString *testRealmPath = RLMTestRealmPath();
     [[NSFileManager defaultManager] removeItemAtPath:[testRealmPath stringByAppendingString:@".lock"] error:nil];
     [[NSFileManager defaultManager] removeItemAtPath:[testRealmPath stringByAppendingString:@".note"] error:nil];
+    [[NSFileManager defaultManager] removeItemAtPath:[testRealmPath stringByAppendingString:@".commit"] error:nil];
 
     // Make parent directory immutable to simulate opening Realm in an app bundle
     NSString *parentDirectoryOfTestRealmPath = [RLMTestRealmPath() stringByDeletingLastPathComponent];
@@ -170,6 +236,18 @@ extern "C" {
     RLMAssertThrowsWithCodeMatching([RLMRealm realmWithConfiguration:config error:nil], RLMErrorFileFormatUpgradeRequired);
 }
 
+- (void)testOpeningWithSchedulerInUseByAnotherRealmThrows {
+    auto scheduler = realm::ExecutorScheduler::make([](std::function<void()> fn) {
+        dispatch_async(dispatch_get_main_queue(), ^{ fn(); });
+    });
+    auto realm = open_int_object_realm(false, scheduler);
+    XCTAssertThrows(open_int_object_realm(false, scheduler));
+
+    // The scheduler can be reused once the Realm using it is gone
+    realm.reset();
+    XCTAssertNoThrow(open_int_object_realm(false, scheduler));
+}
+
 #pragma mark - Adding and Removing Objects
 
 - (void)testRealmAddAndRemoveObjects {
@@ -676,6 +754,40 @@ extern "C" {
     XCTAssertTrue(notificationFired);
 }
 
+- (void)assertBeginTransactionNotifiesOnceWithAdvanceBeforeWriteLock:(bool)advanceBeforeWriteLock {
+    auto writer = open_int_object_realm();
+    auto table = realm::ObjectStore::table_for_object_type(writer->read_group(), "IntObject");
+    writer->begin_transaction();
+    table->add_empty_row();
+    writer->commit_transaction();
+
+    auto realm = open_int_object_realm(advanceBeforeWriteLock);
+    realm->set_auto_refresh(false);
+    auto context = new CountingBindingContext(*realm, table->get_index_in_group());
+    realm->m_binding_context.reset(context);
+    realm->read_group();
+
+    writer->begin_transaction();
+    table->set_int(0, 0, 5);
+    writer->commit_transaction();
+
+    realm->begin_transaction();
+    XCTAssertEqual(context->will_change_count, 1U);
+    XCTAssertEqual(context->did_change_count, 1U);
+    // The changes are delivered inside the write transaction unless the
+    // Realm was advanced before waiting for the write lock
+    XCTAssertEqual(context->did_change_in_write, !advanceBeforeWriteLock);
+    realm->cancel_transaction();
+}
+
+- (void)testBeginTransactionNotifiesOnce {
+    [self assertBeginTransactionNotifiesOnceWithAdvanceBeforeWriteLock:false];
+}
+
+- (void)testBeginTransactionNotifiesOnceWhenAdvancingBeforeWriteLock {
+    [self assertBeginTransactionNotifiesOnceWithAdvanceBeforeWriteLock:true];
+}
+
 - (void)testBeginWriteTransactionsRefreshesRealm {
     // auto refresh on by default
     RLMRealm *realm = [self realmWithTestPath];
@@ -0,0 +1,168 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#import "RLMTestCase.h"
+
+#import "object_schema.hpp"
+#import "object_store.hpp"
+#import "property.hpp"
+#import "results.hpp"
+#import "schema.hpp"
+#import "shared_realm.hpp"
+
+#import <realm/table.hpp>
+
+#import <vector>
+
+#if !DEBUG && TARGET_OS_IPHONE && !TARGET_IPHONE_SIMULATOR
+
+namespace {
+const size_t object_count = 100000;
+const size_t aggregate_object_count = 2000000;
+
+std::string test_realm_path()
+{
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:@"results-performance.realm"].UTF8String;
+}
+
+realm::SharedRealm open_realm(size_t aggregate_threads = 0)
+{
+    realm::Property value;
+    value.name = "value";
+    value.type = realm::PropertyTypeInt;
+
+    realm::ObjectSchema object_schema;
+    object_schema.name = "IntObject";
+    object_schema.properties.push_back(value);
+
+    realm::Realm::Config config;
+    config.path = test_realm_path();
+    config.cache = false;
+    config.schema = std::make_unique<realm::Schema>(std::vector<realm::ObjectSchema>{object_schema});
+    config.schema_version = 0;
+    config.aggregate_threads = aggregate_threads;
+    return realm::Realm::get_shared_realm(std::move(config));
+}
+
+realm::TableRef table(realm::Realm& realm)
+{
+    return realm::ObjectStore::table_for_object_type(realm.read_group(), "IntObject");
+}
+
+// Make a series of small commits to a table with a large filtered and sorted
+// Results, reading the Results after each one
+void commit_and_read(bool incremental, size_t commit_count)
+{
+    auto realm = open_realm();
+    realm::Results results(realm, table(*realm)->where().less(0, int64_t(object_count / 2)), {{0}, {true}});
+    if (incremental) {
+        results.enable_incremental_updates();
+    }
+    results.size();
+
+    for (size_t i = 0; i < commit_count; ++i) {
+        realm->begin_transaction();
+        auto t = table(*realm);
+        for (size_t j = 0; j < 10; ++j) {
+            size_t row = (i * 7919 + j * 104729) % t->size();
+            t->set_int(0, row, (t->get_int(0, row) + 1) % object_count);
+        }
+        t->set_int(0, t->add_empty_row(), i % object_count);
+        t->move_last_over(i % t->size());
+        realm->commit_transaction();
+
+        results.size();
+        results.first();
+        results.last();
+    }
+}
+
+// Find the sum, maximum and average of a large table and of a query on it,
+// with the aggregates split between the given number of background threads
+void aggregate(size_t aggregate_threads)
+{
+    auto realm = open_realm(aggregate_threads);
+    realm::Results all(realm, *table(*realm));
+    realm::Results filtered(realm, table(*realm)->where().less(0, int64_t(aggregate_object_count / 2)));
+    for (size_t i = 0; i < 5; ++i) {
+        for (auto results : {&all, &filtered}) {
+            results->sum(0);
+            results->max(0);
+            results->average(0);
+        }
+    }
+}
+} // anonymous namespace
+
+@interface ResultsPerformanceTests : XCTestCase
+@end
+
+@implementation ResultsPerformanceTests
+
+- (void)setUp {
+    [super setUp];
+    RLMDeleteRealmFilesAtPath(@(test_realm_path().c_str()));
+
+    // Create the objects outside of the measured blocks
+    auto realm = open_realm();
+    realm->begin_transaction();
+    auto t = table(*realm);
+    t->add_empty_row(object_count);
+    for (size_t i = 0; i < object_count; ++i) {
+        t->set_int(0, i, (i * 7919) % object_count);
+    }
+    realm->commit_transaction();
+}
+
+- (void)tearDown {
+    RLMDeleteRealmFilesAtPath(@(test_realm_path().c_str()));
+    [super tearDown];
+}
+
+- (void)testSortedResultsRequeriedAfterEachCommit {
+    [self measureBlock:^{ commit_and_read(false, 50); }];
+}
+
+- (void)testSortedResultsUpdatedIncrementallyAfterEachCommit {
+    [self measureBlock:^{ commit_and_read(true, 50); }];
+}
+
+- (void)addAggregateObjects {
+    auto realm = open_realm();
+    realm->begin_transaction();
+    auto t = table(*realm);
+    t->add_empty_row(aggregate_object_count - object_count);
+    for (size_t i = object_count; i < aggregate_object_count; ++i) {
+        t->set_int(0, i, (i * 7919) % aggregate_object_count);
+    }
+    realm->commit_transaction();
+}
+
+- (void)testAggregatesOnOneThread {
+    [self addAggregateObjects];
+    [self measureBlock:^{ aggregate(0); }];
+}
+
+- (void)testAggregatesOnFourThreads {
+    [self addAggregateObjects];
+    [self measureBlock:^{ aggregate(3); }];
+}
+
+@end
+
+#endif
@@ -471,6 +471,35 @@
     RLMAssertThrowsWithReasonMatching([results indexOfObject:deletedObject], @"Object has been invalidated");
 }
 
+- (void)testIndexOfObjectAfterChange
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    EmployeeObject *po1 = [EmployeeObject createInRealm:realm withValue:@{@"name": @"Joe",  @"age": @40, @"hired": @YES}];
+    EmployeeObject *po2 = [EmployeeObject createInRealm:realm withValue:@{@"name": @"John", @"age": @30, @"hired": @NO}];
+    EmployeeObject *po3 = [EmployeeObject createInRealm:realm withValue:@{@"name": @"Jill", @"age": @25, @"hired": @YES}];
+    [realm commitWriteTransaction];
+
+    RLMResults *results = [EmployeeObject objectsWhere:@"hired = YES"];
+    RLMResults *sorted = [results sortedResultsUsingProperty:@"age" ascending:YES];
+    XCTAssertEqual(1U, [results indexOfObject:po3]);
+    XCTAssertEqual(0U, [sorted indexOfObject:po3]);
+
+    [realm beginWriteTransaction];
+    po2.hired = YES;
+    XCTAssertEqual(1U, [results indexOfObject:po2]);
+    XCTAssertEqual(2U, [results indexOfObject:po3]);
+    XCTAssertEqual(1U, [sorted indexOfObject:po2]);
+    XCTAssertEqual(2U, [sorted indexOfObject:po1]);
+
+    [realm deleteObject:po1];
+    XCTAssertEqual(0U, [results indexOfObject:po3]);
+    XCTAssertEqual(1U, [results indexOfObject:po2]);
+    XCTAssertEqual(0U, [sorted indexOfObject:po3]);
+    [realm commitWriteTransaction];
+}
+
 - (void)testIndexOfObjectWhere
 {
     RLMRealm *realm = [RLMRealm defaultRealm];
@@ -615,6 +644,23 @@
     [realm cancelWriteTransaction];
 }
 
+- (void)testLiveUpdateCount {
+    RLMRealm *realm = self.realmWithTestPath;
+    [realm beginWriteTransaction];
+    [IntObject createInRealm:realm withValue:@[@0]];
+
+    RLMResults *objects = [IntObject objectsInRealm:realm where:@"intCol = 0"];
+    XCTAssertEqual(1U, objects.count);
+    XCTAssertEqual(1U, objects.count);
+
+    [IntObject createInRealm:realm withValue:@[@0]];
+    XCTAssertEqual(2U, objects.count);
+    [[IntObject allObjectsInRealm:realm].firstObject setIntCol:1];
+    XCTAssertEqual(1U, objects.count);
+
+    [realm cancelWriteTransaction];
+}
+
 static vm_size_t get_resident_size() {
     struct task_basic_info info;
     mach_msg_type_number_t size = sizeof(info);
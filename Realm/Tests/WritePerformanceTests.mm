@@ -0,0 +1,107 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2015 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#import "RLMTestCase.h"
+
+#import "object_schema.hpp"
+#import "object_store.hpp"
+#import "property.hpp"
+#import "schema.hpp"
+#import "shared_realm.hpp"
+
+#import <realm/table.hpp>
+
+#import <thread>
+#import <vector>
+
+#if !DEBUG && TARGET_OS_IPHONE && !TARGET_IPHONE_SIMULATOR
+
+namespace {
+std::string test_realm_path()
+{
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:@"write-performance.realm"].UTF8String;
+}
+
+realm::Realm::Config make_config(bool group_commit)
+{
+    realm::Property value;
+    value.name = "value";
+    value.type = realm::PropertyTypeInt;
+
+    realm::ObjectSchema object_schema;
+    object_schema.name = "IntObject";
+    object_schema.properties.push_back(value);
+
+    realm::Realm::Config config;
+    config.path = test_realm_path();
+    config.cache = false;
+    config.group_commit = group_commit;
+    config.schema = std::make_unique<realm::Schema>(std::vector<realm::ObjectSchema>{object_schema});
+    config.schema_version = 0;
+    return config;
+}
+
+// Each thread makes `writes_per_thread` separate writes of a single object
+void write_from_threads(bool group_commit, size_t thread_count, size_t writes_per_thread)
+{
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads.emplace_back([=] {
+            auto realm = realm::Realm::get_shared_realm(make_config(group_commit));
+            for (size_t j = 0; j < writes_per_thread; ++j) {
+                realm->write([](realm::Realm& realm) {
+                    auto table = realm::ObjectStore::table_for_object_type(realm.read_group(), "IntObject");
+                    table->set_int(0, table->add_empty_row(), 1);
+                });
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+} // anonymous namespace
+
+@interface WritePerformanceTests : XCTestCase
+@end
+
+@implementation WritePerformanceTests
+
+- (void)setUp {
+    [super setUp];
+    RLMDeleteRealmFilesAtPath(@(test_realm_path().c_str()));
+    // Create the file and its schema outside of the measured blocks
+    realm::Realm::get_shared_realm(make_config(false));
+}
+
+- (void)tearDown {
+    RLMDeleteRealmFilesAtPath(@(test_realm_path().c_str()));
+    [super tearDown];
+}
+
+- (void)testConcurrentWritesPerThreadCommits {
+    [self measureBlock:^{ write_from_threads(false, 8, 100); }];
+}
+
+- (void)testConcurrentWritesGroupCommit {
+    [self measureBlock:^{ write_from_threads(true, 8, 100); }];
+}
+
+@end
+
+#endif